@@ -65,6 +65,10 @@
 #define GPIOA_USART2_TX         2U
 #define GPIOA_USART2_RX         3U
 
+#define GPIOA_VBAT_SENSE        1U
+#define GPIOA_ICHASSIS_SENSE    4U
+#define GPIOA_VCAP_SENSE        5U
+
 #define GPIOB_I2C2_SCL          10U
 #define GPIOB_I2C2_SDA          11U
 
@@ -114,8 +118,11 @@ following refer to stm32f1 reference manual section 9.1
  * 5 - (GPIOA_LED 8)
  * 4 - (GPIOA_BUTTON 15) ##the board has hardware debouncing and pull-up resistor installed to the button
  * B - (GPIOA_USART1_TX 9)
+ * 0 - (GPIOA_VBAT_SENSE 1)
+ * 0 - (GPIOA_ICHASSIS_SENSE 4)
+ * 0 - (GPIOA_VCAP_SENSE 5)
  */
-#define VAL_GPIOACRL            0x88888882      /*  PA7...PA0 */
+#define VAL_GPIOACRL            0x88008802      /*  PA7...PA0 */
 #define VAL_GPIOACRH            0x588B48B4      /* PA15...PA8 */
 #define VAL_GPIOAODR            0xFFFFFFFF
 
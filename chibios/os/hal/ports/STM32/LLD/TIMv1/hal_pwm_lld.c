@@ -1044,6 +1044,52 @@ void pwm_lld_serve_interrupt(PWMDriver *pwmp) {
     pwmp->config->callback(pwmp);
 }
 
+/**
+ * @brief   Changes the pulse width of a group of channels at once.
+ * @details The compare registers are preloaded, update events are held off
+ *          while they are written so that all the new widths are transferred
+ *          together at the same cycle start. The counter keeps running, a
+ *          cycle ending during the writes keeps the previous widths.
+ * @note    A cycle ending during the writes generates no update event, its
+ *          period callback is not called and a TRGO on update is not
+ *          output. A control loop or an ADC paced from the update loses
+ *          that cycle. The window lasts a few bus cycles per channel and
+ *          runs under the kernel lock, it is only hit when the call lands
+ *          at the very end of a period.
+ * @pre     The channels must have been enabled using @p pwmEnableChannel().
+ * @note    Not reentrant, a driver must be updated from a single context.
+ *
+ * @param[in] pwmp      pointer to a @p PWMDriver object
+ * @param[in] widths    pulse widths of channels 0...n-1 as clock pulses
+ * @param[in] n         number of channels to be updated
+ *
+ * @xclass
+ */
+void pwmSTM32SetWidthsX(PWMDriver *pwmp, const pwmcnt_t *widths,
+                        pwmchannel_t n) {
+  pwmchannel_t channel;
+  syssts_t sts;
+
+  osalDbgCheck(n <= pwmp->channels);
+
+  /* CR1 is read-modify-written, the lock keeps it consistent with the
+     driver start and stop which write it under the lock as well.*/
+  sts = osalSysGetStatusAndLockX();
+  pwmp->tim->CR1 |= STM32_TIM_CR1_UDIS;
+  for (channel = 0; channel < n; channel++) {
+#if STM32_TIM_MAX_CHANNELS <= 4
+    pwmp->tim->CCR[channel] = widths[channel];
+#else
+    if (channel < 4)
+      pwmp->tim->CCR[channel] = widths[channel];
+    else
+      pwmp->tim->CCXR[channel - 4] = widths[channel];
+#endif
+  }
+  pwmp->tim->CR1 &= ~STM32_TIM_CR1_UDIS;
+  osalSysRestoreStatusX(sts);
+}
+
 #endif /* HAL_USE_PWM */
 
 /** @} */
@@ -666,6 +666,23 @@ struct PWMDriver {
 #define pwm_lld_change_period(pwmp, period)                                 \
   ((pwmp)->tim->ARR = ((period) - 1))
 
+/**
+ * @brief   Changes a channel pulse width without entering the kernel.
+ * @details Fast path for control loop interrupts, the width is written in
+ *          the preloaded compare register and takes effect at the next
+ *          cycle start.
+ * @pre     The channel must have been enabled using @p pwmEnableChannel().
+ * @note    Channels 5 and 6 of the advanced timers are not supported.
+ *
+ * @param[in] pwmp      pointer to a @p PWMDriver object
+ * @param[in] channel   PWM channel identifier (0...3)
+ * @param[in] width     PWM pulse width as clock pulses number
+ *
+ * @xclass
+ */
+#define pwmSTM32SetWidthX(pwmp, channel, width)                             \
+  ((pwmp)->tim->CCR[channel] = (width))
+
 /*===========================================================================*/
 /* External declarations.                                                    */
 /*===========================================================================*/
@@ -731,6 +748,10 @@ extern "C" {
   void pwm_lld_disable_channel_notification(PWMDriver *pwmp,
                                             pwmchannel_t channel);
   void pwm_lld_serve_interrupt(PWMDriver *pwmp);
+  /* A period ending inside the update window gets no period callback
+     and no update TRGO, see the function documentation.*/
+  void pwmSTM32SetWidthsX(PWMDriver *pwmp, const pwmcnt_t *widths,
+                          pwmchannel_t n);
 #ifdef __cplusplus
 }
 #endif
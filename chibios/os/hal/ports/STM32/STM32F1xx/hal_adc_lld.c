@@ -213,8 +213,11 @@ void adc_lld_start_conversion(ADCDriver *adcp) {
   adcp->adc->SQR2  = grpp->sqr2;
   adcp->adc->SQR3  = grpp->sqr3;
 
-  /* ADC start by writing ADC_CR2_ADON a second time.*/
-  adcp->adc->CR2   = cr2;
+  /* ADC start by writing ADC_CR2_ADON a second time, groups triggered by
+     a timer or EXTI event are instead started by the first event.*/
+  if (((cr2 & ADC_CR2_EXTTRIG) == 0) ||
+      ((cr2 & ADC_CR2_EXTSEL) == ADC_CR2_EXTSEL_SWSTART))
+    adcp->adc->CR2 = cr2;
 }
 
 /**
@@ -230,6 +233,83 @@ void adc_lld_stop_conversion(ADCDriver *adcp) {
   adcp->adc->CR2 = 0;
 }
 
+/**
+ * @brief   Sets the phase of a timer trigger within the timer period.
+ * @details The compare channel feeding the selected trigger is programmed
+ *          so that its rising edge falls @p phase counts after the update
+ *          event, the ADC samples at a fixed offset from the start of
+ *          every period of the timer.
+ *          For @p ADC_CR2_EXTSEL_TIM3_TRGO the TRGO output of TIM3 is
+ *          switched to OC1REF and channel 1 is used for the phase.
+ * @note    The timer must be clocked, call this function after starting
+ *          the driver owning the timer, e.g. after @p gptStart().
+ * @note    The compare outputs are only routed internally, the pins are
+ *          not affected unless they are also programmed as alternate.
+ *
+ * @param[in] tim       pointer to the timer registers block
+ * @param[in] extsel    one of the @p ADC_CR2_EXTSEL_TIMx_yyy sources
+ * @param[in] phase     trigger offset from the update event in timer
+ *                      counts, it must be lower than the timer period
+ *
+ * @api
+ */
+void adcSTM32SetTriggerPhase(stm32_tim_t *tim, uint32_t extsel,
+                             uint32_t phase) {
+  uint32_t ch, ocm;
+
+  switch (extsel) {
+  case ADC_CR2_EXTSEL_TIM1_CC1:
+  case ADC_CR2_EXTSEL_TIM3_TRGO:
+    ch = 0U;
+    break;
+  case ADC_CR2_EXTSEL_TIM1_CC2:
+  case ADC_CR2_EXTSEL_TIM2_CC2:
+    ch = 1U;
+    break;
+  case ADC_CR2_EXTSEL_TIM1_CC3:
+    ch = 2U;
+    break;
+  case ADC_CR2_EXTSEL_TIM4_CC4:
+    ch = 3U;
+    break;
+  default:
+    osalDbgAssert(false, "not a timer trigger");
+    return;
+  }
+
+  /* PWM mode 2 rises when the counter reaches CCRx, a zero phase instead
+     uses PWM mode 1 which rises on the update event.*/
+  if (phase == 0U) {
+    ocm   = 6U;
+    phase = 1U;
+  }
+  else {
+    ocm   = 7U;
+  }
+
+  if (ch == 0U)
+    tim->CCMR1 = (tim->CCMR1 & ~(STM32_TIM_CCMR1_CC1S_MASK |
+                                 STM32_TIM_CCMR1_OC1M_MASK)) |
+                 STM32_TIM_CCMR1_OC1M(ocm);
+  else if (ch == 1U)
+    tim->CCMR1 = (tim->CCMR1 & ~(STM32_TIM_CCMR1_CC2S_MASK |
+                                 STM32_TIM_CCMR1_OC2M_MASK)) |
+                 STM32_TIM_CCMR1_OC2M(ocm);
+  else if (ch == 2U)
+    tim->CCMR2 = (tim->CCMR2 & ~(STM32_TIM_CCMR2_CC3S_MASK |
+                                 STM32_TIM_CCMR2_OC3M_MASK)) |
+                 STM32_TIM_CCMR2_OC3M(ocm);
+  else
+    tim->CCMR2 = (tim->CCMR2 & ~(STM32_TIM_CCMR2_CC4S_MASK |
+                                 STM32_TIM_CCMR2_OC4M_MASK)) |
+                 STM32_TIM_CCMR2_OC4M(ocm);
+  tim->CCR[ch] = phase;
+  tim->CCER   |= STM32_TIM_CCER_CC1E << (ch * 4U);
+
+  if (extsel == ADC_CR2_EXTSEL_TIM3_TRGO)
+    tim->CR2 = (tim->CR2 & ~STM32_TIM_CR2_MMS_MASK) | STM32_TIM_CR2_MMS(4);
+}
+
 #endif /* HAL_USE_ADC */
 
 /** @} */
@@ -25,6 +25,8 @@
 #ifndef HAL_ADC_LLD_H
 #define HAL_ADC_LLD_H
 
+#include "stm32_tim.h"
+
 #if HAL_USE_ADC || defined(__DOXYGEN__)
 
 /*===========================================================================*/
@@ -36,6 +38,13 @@
  * @{
  */
 #define ADC_CR2_EXTSEL_SRC(n)   ((n) << 17) /**< @brief Trigger source.     */
+#define ADC_CR2_EXTSEL_TIM1_CC1 (0 << 17)   /**< @brief TIM1 CC1 event.     */
+#define ADC_CR2_EXTSEL_TIM1_CC2 (1 << 17)   /**< @brief TIM1 CC2 event.     */
+#define ADC_CR2_EXTSEL_TIM1_CC3 (2 << 17)   /**< @brief TIM1 CC3 event.     */
+#define ADC_CR2_EXTSEL_TIM2_CC2 (3 << 17)   /**< @brief TIM2 CC2 event.     */
+#define ADC_CR2_EXTSEL_TIM3_TRGO (4 << 17)  /**< @brief TIM3 TRGO event.    */
+#define ADC_CR2_EXTSEL_TIM4_CC4 (5 << 17)   /**< @brief TIM4 CC4 event.     */
+#define ADC_CR2_EXTSEL_EXTI11   (6 << 17)   /**< @brief EXTI line 11.       */
 #define ADC_CR2_EXTSEL_SWSTART  (7 << 17)   /**< @brief Software trigger.   */
 /** @} */
 
@@ -181,7 +190,10 @@ typedef enum {
   /* ADC CR2 register initialization data.                                  \
      NOTE: All the required bits must be defined into this field except     \
            @p ADC_CR2_DMA, @p ADC_CR2_CONT and @p ADC_CR2_ADON that are     \
-           enforced inside the driver.*/                                    \
+           enforced inside the driver.                                      \
+     NOTE: Timer triggered groups specify @p ADC_CR2_EXTTRIG and one of     \
+           the @p ADC_CR2_EXTSEL_TIMx_yyy sources, one scan of the          \
+           sequence is performed on every trigger event.*/                  \
   uint32_t                  cr2;                                            \
   /* ADC SMPR1 register initialization data.                                \
      NOTE: In this field must be specified the sample times for channels    \
@@ -273,6 +285,8 @@ extern "C" {
   void adc_lld_stop(ADCDriver *adcp);
   void adc_lld_start_conversion(ADCDriver *adcp);
   void adc_lld_stop_conversion(ADCDriver *adcp);
+  void adcSTM32SetTriggerPhase(stm32_tim_t *tim, uint32_t extsel,
+                               uint32_t phase);
 #ifdef __cplusplus
 }
 #endif
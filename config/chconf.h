@@ -153,7 +153,7 @@
  *
  * @note    The default is @p TRUE.
  */
-#define CH_CFG_USE_TM                       FALSE
+#define CH_CFG_USE_TM                       TRUE
 
 /**
  * @brief   Threads registry APIs.
@@ -578,7 +578,7 @@
  * @details This hook is continuously invoked by the idle thread loop.
  */
 #define CH_CFG_IDLE_LOOP_HOOK() {                                           \
-  /* Idle loop code here.*/                                                 \
+  idleSleep();                                                              \
 }
 
 /**
@@ -614,6 +614,21 @@
 /* Port-specific settings (override port settings defaulted in chcore.h).    */
 /*===========================================================================*/
 
+/*===========================================================================*/
+/* Hook functions.                                                           */
+/*===========================================================================*/
+
+#if !defined(_FROM_ASM_)
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+  void idleSleep(void);
+#ifdef __cplusplus
+}
+#endif
+#endif /* !defined(_FROM_ASM_) */
+
 #endif  /* CHCONF_H */
 
 /** @} */
\ No newline at end of file
@@ -9,7 +9,7 @@ ifeq ($(USE_OPT),)
   -D SHELL_CONFIG_FILE \
   -D CHPRINTF_USE_FLOAT \
   -D BOARD_OTG_NOVBUSSENS \
-  -D ARM_MATH_CM4
+  -D ARM_MATH_CM3
 endif
 
 # C specific options here (added to USE_OPT).
@@ -75,12 +75,7 @@ endif
 
 # Enables the use of FPU (no, softfp, hard).
 ifeq ($(USE_FPU),)
-  USE_FPU = hard
-endif
-
-# FPU-related options.
-ifeq ($(USE_FPU_OPT),)
-  USE_FPU_OPT = -mfloat-abi=$(USE_FPU) -mfpu=fpv4-sp-d16
+  USE_FPU = no
 endif
 
 #
@@ -113,6 +108,29 @@ include $(CHIBIOS)/os/various/cpp_wrappers/chcpp.mk
 # Other files (optional).
 include $(CHIBIOS)/os/hal/lib/streams/streams.mk
 include $(COREDIR)/src/shell/shell.mk
+include $(COREDIR)/src/adc_stream/adc_stream.mk
+include $(COREDIR)/src/speed_sensor/speed_sensor.mk
+include $(COREDIR)/src/timestamp/timestamp.mk
+include $(COREDIR)/src/fixmath/fixmath.mk
+include $(COREDIR)/src/pid/pid.mk
+include $(COREDIR)/src/attitude/attitude.mk
+include $(COREDIR)/src/motor/motor.mk
+include $(COREDIR)/src/biquad/biquad.mk
+include $(COREDIR)/src/vibration/vibration.mk
+include $(COREDIR)/src/lqr/lqr.mk
+include $(COREDIR)/src/ekf/ekf.mk
+include $(COREDIR)/src/odometry/odometry.mk
+include $(COREDIR)/src/traj/traj.mk
+include $(COREDIR)/src/nn/nn.mk
+include $(COREDIR)/src/latency/latency.mk
+include $(COREDIR)/src/topic/topic.mk
+include $(COREDIR)/src/channel/channel.mk
+include $(COREDIR)/src/work/work.mk
+include $(COREDIR)/src/objreg/objreg.mk
+include $(COREDIR)/src/boot/boot.mk
+include $(COREDIR)/src/warm/warm.mk
+include $(COREDIR)/src/watchdog/watchdog.mk
+include $(COREDIR)/src/idle/idle.mk
 
 # Define linker script file here
 LDSCRIPT= $(COREDIR)/$(BOARD_NAME).ld
@@ -159,7 +177,7 @@ INCDIR = $(ALLINC) $(TESTINC) $(CONFDIR) $(COREDIR)
 # Compiler settings
 #
 
-MCU  = cortex-m4
+MCU  = cortex-m3
 
 #TRGT = arm-elf-
 TRGT = arm-none-eabi-
@@ -211,7 +229,7 @@ UINCDIR += $(COREDIR)/CMSIS/DSP/Include
 ULIBDIR = $(COREDIR)/CMSIS/Lib/GCC
 
 # List all user libraries here
-ULIBS = -larm_cortexM4lf_math -lm -lstdc++
+ULIBS = -larm_cortexM3l_math -lm -lstdc++
 
 $(info -------------------------------)
 $(info C source files:)
@@ -0,0 +1,185 @@
+/**
+ * @file    adc_stream.c
+ * @brief   Continuous ADC sampling with DMA double-buffering and decimation.
+ * @details ADC1 scans all the channels continuously, or once per timer
+ *          event, into a circular DMA buffer. Each half buffer is
+ *          de-interleaved, low-pass filtered and decimated from the DMA
+ *          callback itself, so no thread is woken up for the samples. The
+ *          latest filtered values are published under a sequence counter
+ *          and read without locking.
+ *
+ * @addtogroup ADC_STREAM
+ * @{
+ */
+
+#include "ch.h"
+#include "hal.h"
+#include "adc_stream.h"
+#include "timestamp.h"
+
+/*===========================================================================*/
+/* Module local definitions.                                                 */
+/*===========================================================================*/
+
+#define ADC_STREAM_OUT_SIZE (ADC_STREAM_BLOCK_SIZE / ADC_STREAM_DECIMATION)
+
+/*===========================================================================*/
+/* Module exported variables.                                                */
+/*===========================================================================*/
+
+/*===========================================================================*/
+/* Module local types.                                                       */
+/*===========================================================================*/
+
+/*===========================================================================*/
+/* Module local variables.                                                   */
+/*===========================================================================*/
+
+/**
+ * @brief   Anti-aliasing filter, Hamming windowed sinc.
+ * @details Cutoff at 0.8 of the decimated Nyquist frequency, unity DC gain.
+ */
+static const q15_t fir_coeffs[ADC_STREAM_FIR_TAPS] = {
+    -54, -64, -82, -97, -93, -47, 66, 266,
+    562, 951, 1412, 1909, 2396, 2821, 3136, 3301,
+    3301, 3136, 2821, 2396, 1909, 1412, 951, 562,
+    266, 66, -47, -93, -97, -82, -64, -54};
+
+/**
+ * @brief   DMA buffer, two halves of @p ADC_STREAM_BLOCK_SIZE scans.
+ */
+static adcsample_t samples[2 * ADC_STREAM_BLOCK_SIZE * ADC_STREAM_NUM_CHANNELS];
+
+static arm_fir_decimate_instance_q15 fir[ADC_STREAM_NUM_CHANNELS];
+static q15_t fir_state[ADC_STREAM_NUM_CHANNELS]
+                      [ADC_STREAM_FIR_TAPS + ADC_STREAM_BLOCK_SIZE - 1];
+static q15_t fir_in[ADC_STREAM_BLOCK_SIZE];
+static q15_t fir_out[ADC_STREAM_OUT_SIZE];
+
+/**
+ * @brief   Published values and their sequence counter.
+ * @note    Only the DMA ISR writes, so a reader sees a changed counter if
+ *          and only if it has been preempted by an update.
+ */
+static volatile q15_t latest[ADC_STREAM_NUM_CHANNELS];
+static volatile uint32_t latest_seq;
+
+static void adc_stream_cb(ADCDriver *adcp);
+
+/*
+ * Battery voltage on PA1, chassis current on PA4, supercap voltage on PA5.
+ * The order of the sequence follows the ADC_STREAM_* channel indexes.
+ */
+static const ADCConversionGroup adcgrpcfg = {
+    true,
+    ADC_STREAM_NUM_CHANNELS,
+    adc_stream_cb,
+    NULL,
+    0, /* CR1 */
+    ADC_STREAM_CR2, /* CR2 */
+    0, /* SMPR1 */
+    ADC_SMPR2_SMP_AN1(ADC_STREAM_SAMPLE_TIME) |
+        ADC_SMPR2_SMP_AN4(ADC_STREAM_SAMPLE_TIME) |
+        ADC_SMPR2_SMP_AN5(ADC_STREAM_SAMPLE_TIME), /* SMPR2 */
+    ADC_SQR1_NUM_CH(ADC_STREAM_NUM_CHANNELS),      /* SQR1 */
+    0,                                             /* SQR2 */
+    ADC_SQR3_SQ1_N(ADC_CHANNEL_IN1) | ADC_SQR3_SQ2_N(ADC_CHANNEL_IN4) |
+        ADC_SQR3_SQ3_N(ADC_CHANNEL_IN5) /* SQR3 */
+};
+
+/*===========================================================================*/
+/* Module local functions.                                                   */
+/*===========================================================================*/
+
+/**
+ * @brief   Half/full buffer callback, runs in the DMA ISR.
+ */
+static void adc_stream_cb(ADCDriver *adcp)
+{
+  const adcsample_t *buf = samples;
+  unsigned ch, i;
+
+  tsStampX(TS_SOURCE_ADC);
+
+  if (adcIsBufferComplete(adcp))
+    buf += ADC_STREAM_BLOCK_SIZE * ADC_STREAM_NUM_CHANNELS;
+
+  latest_seq++;
+  for (ch = 0; ch < ADC_STREAM_NUM_CHANNELS; ch++)
+  {
+    /* 12 bits right aligned to positive Q15.*/
+    for (i = 0; i < ADC_STREAM_BLOCK_SIZE; i++)
+      fir_in[i] = (q15_t)(buf[i * ADC_STREAM_NUM_CHANNELS + ch] << 3);
+
+    arm_fir_decimate_q15(&fir[ch], fir_in, fir_out, ADC_STREAM_BLOCK_SIZE);
+    latest[ch] = fir_out[ADC_STREAM_OUT_SIZE - 1];
+  }
+  latest_seq++;
+}
+
+/*===========================================================================*/
+/* Module exported functions.                                                */
+/*===========================================================================*/
+
+/**
+ * @brief   Starts the continuous sampling of all the channels.
+ * @note    With a timer @p ADC_STREAM_TRIGGER the trigger timer is owned by
+ *          the caller, which starts it and sets the sampling phase with
+ *          @p adcSTM32SetTriggerPhase().
+ *
+ * @api
+ */
+void adcStreamInit(void)
+{
+  unsigned ch;
+
+  for (ch = 0; ch < ADC_STREAM_NUM_CHANNELS; ch++)
+    arm_fir_decimate_init_q15(&fir[ch], ADC_STREAM_FIR_TAPS,
+                              ADC_STREAM_DECIMATION, (q15_t *)fir_coeffs,
+                              fir_state[ch], ADC_STREAM_BLOCK_SIZE);
+
+  adcStart(&ADCD1, NULL);
+  adcStartConversion(&ADCD1, &adcgrpcfg, samples, 2 * ADC_STREAM_BLOCK_SIZE);
+}
+
+/**
+ * @brief   Latest filtered value of a channel.
+ *
+ * @param[in] channel   one of the @p ADC_STREAM_* channel indexes
+ * @return              The value in Q15, full scale is VREF+.
+ *
+ * @api
+ */
+q15_t adcStreamGet(unsigned channel)
+{
+  chDbgCheck(channel < ADC_STREAM_NUM_CHANNELS);
+
+  return latest[channel];
+}
+
+/**
+ * @brief   Consistent snapshot of all the channels.
+ * @note    Never blocks, retries only when preempted by an update.
+ *
+ * @param[out] values   Q15 values indexed by @p ADC_STREAM_* channel
+ * @return              The sequence number of the snapshot, it advances by
+ *                      two on every half buffer.
+ *
+ * @api
+ */
+uint32_t adcStreamRead(q15_t values[ADC_STREAM_NUM_CHANNELS])
+{
+  uint32_t seq;
+  unsigned ch;
+
+  do
+  {
+    seq = latest_seq;
+    for (ch = 0; ch < ADC_STREAM_NUM_CHANNELS; ch++)
+      values[ch] = latest[ch];
+  } while (seq != latest_seq);
+
+  return seq;
+}
+
+/** @} */
@@ -0,0 +1,135 @@
+/**
+ * @file    adc_stream.h
+ * @brief   Continuous ADC sampling with DMA double-buffering and decimation.
+ *
+ * @addtogroup ADC_STREAM
+ * @{
+ */
+
+#ifndef ADC_STREAM_H
+#define ADC_STREAM_H
+
+#include "ch.h"
+#include "hal.h"
+#include "arm_math.h"
+
+/*===========================================================================*/
+/* Module constants.                                                         */
+/*===========================================================================*/
+
+/**
+ * @brief   Number of taps of the anti-aliasing decimation filter.
+ * @note    The coefficient table in @p adc_stream.c is designed for this
+ *          length and for @p ADC_STREAM_DECIMATION equal to 8.
+ */
+#define ADC_STREAM_FIR_TAPS 32
+
+/**
+ * @name    Sampled channels
+ * @{
+ */
+#define ADC_STREAM_VBAT 0     /**< @brief Battery voltage.              */
+#define ADC_STREAM_ICHASSIS 1 /**< @brief Chassis current.              */
+#define ADC_STREAM_VCAP 2     /**< @brief Supercapacitor voltage.       */
+#define ADC_STREAM_NUM_CHANNELS 3
+/** @} */
+
+/*===========================================================================*/
+/* Module pre-compile time settings.                                         */
+/*===========================================================================*/
+
+/**
+ * @brief   Decimation factor applied to every channel.
+ */
+#if !defined(ADC_STREAM_DECIMATION) || defined(__DOXYGEN__)
+#define ADC_STREAM_DECIMATION 8
+#endif
+
+/**
+ * @brief   Scans per half buffer.
+ * @details Every DMA half/full transfer interrupt processes this many
+ *          samples per channel and produces
+ *          @p ADC_STREAM_BLOCK_SIZE / @p ADC_STREAM_DECIMATION filtered
+ *          samples per channel.
+ */
+#if !defined(ADC_STREAM_BLOCK_SIZE) || defined(__DOXYGEN__)
+#define ADC_STREAM_BLOCK_SIZE 32
+#endif
+
+/**
+ * @brief   Sampling time applied to every channel.
+ */
+#if !defined(ADC_STREAM_SAMPLE_TIME) || defined(__DOXYGEN__)
+#define ADC_STREAM_SAMPLE_TIME ADC_SAMPLE_239P5
+#endif
+
+/**
+ * @brief   Conversion trigger.
+ * @details With @p ADC_CR2_EXTSEL_SWSTART the ADC converts continuously,
+ *          any of the @p ADC_CR2_EXTSEL_TIMx_yyy sources performs one scan
+ *          per timer event instead, equally spaced and phase-aligned with
+ *          the timer period, see @p adcSTM32SetTriggerPhase().
+ */
+#if !defined(ADC_STREAM_TRIGGER) || defined(__DOXYGEN__)
+#define ADC_STREAM_TRIGGER ADC_CR2_EXTSEL_SWSTART
+#endif
+
+/*===========================================================================*/
+/* Derived constants and error checks.                                       */
+/*===========================================================================*/
+
+#if HAL_USE_ADC == FALSE
+#error "ADC_STREAM requires HAL_USE_ADC"
+#endif
+
+#if STM32_ADC_USE_ADC1 == FALSE
+#error "ADC_STREAM requires STM32_ADC_USE_ADC1"
+#endif
+
+/**
+ * @brief   CR2 trigger bits of the conversion group.
+ */
+#if (ADC_STREAM_TRIGGER == ADC_CR2_EXTSEL_SWSTART) || defined(__DOXYGEN__)
+#define ADC_STREAM_CR2 0
+#else
+#define ADC_STREAM_CR2 (ADC_CR2_EXTTRIG | ADC_STREAM_TRIGGER)
+#endif
+
+#if ADC_STREAM_DECIMATION != 8
+#error "ADC_STREAM filter coefficients are designed for a decimation of 8"
+#endif
+
+#if (ADC_STREAM_BLOCK_SIZE % ADC_STREAM_DECIMATION) != 0
+#error "ADC_STREAM_BLOCK_SIZE must be a multiple of ADC_STREAM_DECIMATION"
+#endif
+
+/*===========================================================================*/
+/* Module data structures and types.                                         */
+/*===========================================================================*/
+
+/*===========================================================================*/
+/* Module macros.                                                            */
+/*===========================================================================*/
+
+/*===========================================================================*/
+/* External declarations.                                                    */
+/*===========================================================================*/
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+  void adcStreamInit(void);
+  q15_t adcStreamGet(unsigned channel);
+  uint32_t adcStreamRead(q15_t values[ADC_STREAM_NUM_CHANNELS]);
+#ifdef __cplusplus
+}
+#endif
+
+/*===========================================================================*/
+/* Module inline functions.                                                  */
+/*===========================================================================*/
+
+#endif /* ADC_STREAM_H */
+
+/** @} */
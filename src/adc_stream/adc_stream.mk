@@ -0,0 +1,8 @@
+# Continuous ADC sampling files.
+ADCSTREAMSRC = $(COREDIR)/src/adc_stream/adc_stream.c
+
+ADCSTREAMINC = $(COREDIR)/src/adc_stream
+
+# Shared variables
+ALLCSRC += $(ADCSTREAMSRC)
+ALLINC  += $(ADCSTREAMINC)
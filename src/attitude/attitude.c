@@ -0,0 +1,258 @@
+/**
+ * @file    attitude.c
+ * @brief   Fixed-point attitude estimator.
+ * @details Mahony complementary filter: the gyro rate, corrected by the
+ *          misalignment between the measured and the predicted gravity
+ *          direction, is integrated into the attitude quaternion while the
+ *          integral of the misalignment estimates the gyro bias. Every
+ *          sample carries its own timestamp, the step is the actual
+ *          interval between samples. Quaternion and vectors are Q30, rates
+ *          are rad/s in Q24, intervals are seconds in Q31.
+ *
+ * @addtogroup ATTITUDE
+ * @{
+ */
+
+#include "ch.h"
+#include "hal.h"
+#include "attitude.h"
+#include "fixmath.h"
+
+/*===========================================================================*/
+/* Module local definitions.                                                 */
+/*===========================================================================*/
+
+#define ATT_ONE ((q31_t)1 << 30)
+
+/**
+ * @brief   1/pi in Q31.
+ */
+#define ATT_INV_PI 683565276
+
+/*===========================================================================*/
+/* Module exported variables.                                                */
+/*===========================================================================*/
+
+/*===========================================================================*/
+/* Module local types.                                                       */
+/*===========================================================================*/
+
+/*===========================================================================*/
+/* Module local variables.                                                   */
+/*===========================================================================*/
+
+/*===========================================================================*/
+/* Module local functions.                                                   */
+/*===========================================================================*/
+
+static inline q31_t att_mul(q31_t a, q31_t b)
+{
+  return (q31_t)(((q63_t)a * b) >> 30);
+}
+
+static inline q31_t att_clamp(q63_t x, q31_t lim)
+{
+  if (x > lim)
+    return lim;
+  if (x < -lim)
+    return -lim;
+  return (q31_t)x;
+}
+
+/**
+ * @brief   Integrates one sample.
+ */
+static void att_step(Attitude *ap, const AttitudeSample *sp, q31_t dt)
+{
+  const AttitudeConfig *cfg = ap->config;
+  q31_t *q = ap->q;
+  q31_t w[3], e[3] = {0, 0, 0}, h[3], dq[4], nq[4];
+  q31_t hn, s, c, k;
+  uint64_t n2;
+  uint32_t n;
+  unsigned i;
+
+  /* Gravity correction, skipped while the accelerometer norm is too low
+     to give a direction.*/
+  n2 = (uint64_t)((int32_t)sp->accel[0] * sp->accel[0]) +
+       (uint64_t)((int32_t)sp->accel[1] * sp->accel[1]) +
+       (uint64_t)((int32_t)sp->accel[2] * sp->accel[2]);
+  n = fixSqrt64(n2);
+  if (n >= cfg->accel_min && n > 0)
+  {
+    uint64_t r = (1ULL << 46) / n;
+    q31_t a[3], v[3];
+
+    for (i = 0; i < 3; i++)
+      a[i] = (q31_t)(((int64_t)sp->accel[i] * (int64_t)r) >> 16);
+
+    /* Gravity direction predicted by the current attitude.*/
+    v[0] = 2 * (att_mul(q[1], q[3]) - att_mul(q[0], q[2]));
+    v[1] = 2 * (att_mul(q[0], q[1]) + att_mul(q[2], q[3]));
+    v[2] = att_mul(q[0], q[0]) - att_mul(q[1], q[1]) -
+           att_mul(q[2], q[2]) + att_mul(q[3], q[3]);
+
+    e[0] = att_mul(a[1], v[2]) - att_mul(a[2], v[1]);
+    e[1] = att_mul(a[2], v[0]) - att_mul(a[0], v[2]);
+    e[2] = att_mul(a[0], v[1]) - att_mul(a[1], v[0]);
+  }
+
+  for (i = 0; i < 3; i++)
+  {
+    q63_t bias;
+
+    /* Bias update, ki * e * dt.*/
+    bias = ap->bias[i] -
+           ((((q63_t)cfg->ki * e[i]) >> 30) * dt >> 25);
+    ap->bias[i] = att_clamp(bias, cfg->bias_max);
+
+    w[i] = (q31_t)((((int64_t)sp->gyro[i] * cfg->gyro_scale) >> 8) -
+                   (ap->bias[i] >> 6) +
+                   (((q63_t)cfg->kp * e[i]) >> 30));
+
+    /* Half rotation angle, w * dt / 2.*/
+    h[i] = (q31_t)(((q63_t)w[i] * dt) >> 26);
+  }
+
+  /* Exact rotation by the half angle vector h.*/
+  hn = (q31_t)fixSqrt64((uint64_t)((q63_t)h[0] * h[0]) +
+                        (uint64_t)((q63_t)h[1] * h[1]) +
+                        (uint64_t)((q63_t)h[2] * h[2]));
+  if (hn < 1024)
+  {
+    /* sin(x) / x is 1 at this resolution.*/
+    c = (q31_t)0x7FFFFFFF;
+    k = ATT_ONE;
+  }
+  else
+  {
+    arm_sin_cos_q31((q31_t)(((q63_t)hn * ATT_INV_PI) >> 30), &s, &c);
+    k = (q31_t)(((q63_t)s << 29) / hn);
+  }
+  dq[0] = c >> 1;
+  for (i = 0; i < 3; i++)
+    dq[i + 1] = att_mul(h[i], k);
+
+  nq[0] = (q31_t)(((q63_t)q[0] * dq[0] - (q63_t)q[1] * dq[1] -
+                   (q63_t)q[2] * dq[2] - (q63_t)q[3] * dq[3]) >> 30);
+  nq[1] = (q31_t)(((q63_t)q[0] * dq[1] + (q63_t)q[1] * dq[0] +
+                   (q63_t)q[2] * dq[3] - (q63_t)q[3] * dq[2]) >> 30);
+  nq[2] = (q31_t)(((q63_t)q[0] * dq[2] - (q63_t)q[1] * dq[3] +
+                   (q63_t)q[2] * dq[0] + (q63_t)q[3] * dq[1]) >> 30);
+  nq[3] = (q31_t)(((q63_t)q[0] * dq[3] + (q63_t)q[1] * dq[2] -
+                   (q63_t)q[2] * dq[1] + (q63_t)q[3] * dq[0]) >> 30);
+
+  /* Renormalization against the rounding drift.*/
+  n = fixSqrt64((uint64_t)((q63_t)nq[0] * nq[0]) +
+                (uint64_t)((q63_t)nq[1] * nq[1]) +
+                (uint64_t)((q63_t)nq[2] * nq[2]) +
+                (uint64_t)((q63_t)nq[3] * nq[3]));
+  if (n == 0)
+  {
+    q[0] = ATT_ONE;
+    q[1] = q[2] = q[3] = 0;
+    return;
+  }
+  k = (q31_t)((1ULL << 60) / n);
+  for (i = 0; i < 4; i++)
+    q[i] = att_mul(nq[i], k);
+}
+
+/*===========================================================================*/
+/* Module exported functions.                                                */
+/*===========================================================================*/
+
+/**
+ * @brief   Initializes an estimator, level and without bias.
+ *
+ * @param[out] ap       pointer to the @p Attitude object
+ * @param[in] config    pointer to the estimator configuration
+ *
+ * @api
+ */
+void attInit(Attitude *ap, const AttitudeConfig *config)
+{
+  unsigned i;
+
+  ap->config = config;
+  ap->last = 0;
+  ap->q[0] = ap->out[0] = ATT_ONE;
+  for (i = 0; i < 3; i++)
+  {
+    ap->q[i + 1] = ap->out[i + 1] = 0;
+    ap->bias[i] = 0;
+  }
+}
+
+/**
+ * @brief   Integrates a batch of samples.
+ * @details The attitude is published once per batch.
+ *
+ * @param[in] ap        pointer to the @p Attitude object
+ * @param[in] samples   samples in time order
+ * @param[in] n         number of samples
+ *
+ * @api
+ */
+void attUpdate(Attitude *ap, const AttitudeSample *samples, unsigned n)
+{
+  unsigned i;
+
+  for (i = 0; i < n; i++)
+  {
+    const AttitudeSample *sp = &samples[i];
+    tstamp_t dts;
+
+    if (ap->last != 0)
+    {
+      dts = sp->t - ap->last;
+      if (dts > US2TS(ATT_MAX_DT_US))
+        dts = US2TS(ATT_MAX_DT_US);
+      att_step(ap, sp, TS2Q31(dts));
+    }
+    ap->last = sp->t;
+  }
+
+  chSysLock();
+  for (i = 0; i < 4; i++)
+    ap->out[i] = ap->q[i];
+  chSysUnlock();
+}
+
+/**
+ * @brief   Latest attitude.
+ *
+ * @param[in] ap        pointer to the @p Attitude object
+ * @param[out] q        attitude quaternion, W X Y Z in Q30
+ *
+ * @api
+ */
+void attGetQuaternion(Attitude *ap, q31_t q[4])
+{
+  unsigned i;
+
+  chSysLock();
+  for (i = 0; i < 4; i++)
+    q[i] = ap->out[i];
+  chSysUnlock();
+}
+
+/**
+ * @brief   Estimated gyro bias.
+ *
+ * @param[in] ap        pointer to the @p Attitude object
+ * @param[out] bias     bias, X Y Z rad/s in Q30
+ *
+ * @api
+ */
+void attGetGyroBias(Attitude *ap, q31_t bias[3])
+{
+  unsigned i;
+
+  chSysLock();
+  for (i = 0; i < 3; i++)
+    bias[i] = ap->bias[i];
+  chSysUnlock();
+}
+
+/** @} */
@@ -0,0 +1,129 @@
+/**
+ * @file    attitude.h
+ * @brief   Fixed-point attitude estimator.
+ *
+ * @addtogroup ATTITUDE
+ * @{
+ */
+
+#ifndef ATTITUDE_H
+#define ATTITUDE_H
+
+#include "ch.h"
+#include "hal.h"
+#include "arm_math.h"
+#include "timestamp.h"
+
+/*===========================================================================*/
+/* Module constants.                                                         */
+/*===========================================================================*/
+
+/*===========================================================================*/
+/* Module pre-compile time settings.                                         */
+/*===========================================================================*/
+
+/**
+ * @brief   Longest integration step, in microseconds.
+ * @details A gap between two samples longer than this, e.g. a lost batch,
+ *          is integrated as this interval.
+ */
+#if !defined(ATT_MAX_DT_US) || defined(__DOXYGEN__)
+#define ATT_MAX_DT_US 10000
+#endif
+
+/*===========================================================================*/
+/* Derived constants and error checks.                                       */
+/*===========================================================================*/
+
+#if ATT_MAX_DT_US >= 1000000
+#error "ATT_MAX_DT_US must be shorter than one second"
+#endif
+
+/*===========================================================================*/
+/* Module data structures and types.                                         */
+/*===========================================================================*/
+
+/**
+ * @brief   Estimator configuration.
+ */
+typedef struct
+{
+  uint32_t gyro_scale; /**< @brief Gyro sensitivity, rad/s per LSB in
+                                   Q0.32, see @p ATT_GYRO_SCALE().      */
+  int32_t kp;          /**< @brief Accelerometer correction
+                                   proportional gain, 1/s in Q24.       */
+  int32_t ki;          /**< @brief Gyro bias estimation gain, 1/s^2 in
+                                   Q24.                                 */
+  int32_t bias_max;    /**< @brief Bias estimate limit, rad/s in Q30.   */
+  uint32_t accel_min;  /**< @brief Smallest accelerometer norm used for
+                                   the correction, in LSB.              */
+} AttitudeConfig;
+
+/**
+ * @brief   IMU sample.
+ */
+typedef struct
+{
+  tstamp_t t;        /**< @brief Sampling time.                         */
+  int16_t accel[3];  /**< @brief Raw accelerometer, X Y Z.              */
+  int16_t gyro[3];   /**< @brief Raw gyro, X Y Z.                       */
+} AttitudeSample;
+
+/**
+ * @brief   Estimator object.
+ */
+typedef struct
+{
+  const AttitudeConfig *config; /**< @brief Estimator configuration.    */
+  tstamp_t last;                /**< @brief Time of the last sample,
+                                            zero before the first one.  */
+  q31_t q[4];                   /**< @brief Attitude, W X Y Z in Q30.   */
+  q31_t bias[3];                /**< @brief Estimated gyro bias, rad/s
+                                            in Q30.                     */
+  q31_t out[4];                 /**< @brief Published attitude.         */
+} Attitude;
+
+/*===========================================================================*/
+/* Module macros.                                                            */
+/*===========================================================================*/
+
+/**
+ * @brief   Gyro sensitivity from the full scale range.
+ * @note    Meant for constant expressions only.
+ *
+ * @param[in] dps       full scale in degrees per second, e.g. 2000
+ */
+#define ATT_GYRO_SCALE(dps)                                              \
+  ((uint32_t)((dps) * 3.14159265358979 / 180.0 / 32768.0 * 4294967296.0))
+
+/**
+ * @brief   Gain constant to Q24.
+ * @note    Meant for constant expressions only.
+ *
+ * @param[in] x         gain value
+ */
+#define ATT_GAIN(x) ((int32_t)((x) * 16777216.0))
+
+/*===========================================================================*/
+/* External declarations.                                                    */
+/*===========================================================================*/
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+  void attInit(Attitude *ap, const AttitudeConfig *config);
+  void attUpdate(Attitude *ap, const AttitudeSample *samples, unsigned n);
+  void attGetQuaternion(Attitude *ap, q31_t q[4]);
+  void attGetGyroBias(Attitude *ap, q31_t bias[3]);
+#ifdef __cplusplus
+}
+#endif
+
+/*===========================================================================*/
+/* Module inline functions.                                                  */
+/*===========================================================================*/
+
+#endif /* ATTITUDE_H */
+
+/** @} */
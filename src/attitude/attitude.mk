@@ -0,0 +1,8 @@
+# Attitude estimator files.
+ATTITUDESRC = $(COREDIR)/src/attitude/attitude.c
+
+ATTITUDEINC = $(COREDIR)/src/attitude
+
+# Shared variables
+ALLCSRC += $(ATTITUDESRC)
+ALLINC  += $(ATTITUDEINC)
@@ -0,0 +1,198 @@
+/**
+ * @file    biquad.c
+ * @brief   Low-pass and notch biquad filter cascades.
+ * @details Sections are designed with the audio EQ cookbook formulas in
+ *          fixed point, the angular frequency goes through
+ *          @p arm_sin_cos_q31(). Coefficients are Q30 with a post shift of
+ *          one so that the feedback terms up to 2 are representable.
+ *          Blocks run through @p arm_biquad_cascade_df1_q31(), the direct
+ *          form I state is made of past inputs and outputs only so it stays
+ *          valid when the coefficients change between two blocks.
+ *
+ * @addtogroup BIQUAD
+ * @{
+ */
+
+#include "ch.h"
+#include "biquad.h"
+
+/*===========================================================================*/
+/* Module local definitions.                                                 */
+/*===========================================================================*/
+
+#define BIQUAD_ONE ((q63_t)1 << 30)
+
+/*===========================================================================*/
+/* Module exported variables.                                                */
+/*===========================================================================*/
+
+/*===========================================================================*/
+/* Module local types.                                                       */
+/*===========================================================================*/
+
+/*===========================================================================*/
+/* Module local variables.                                                   */
+/*===========================================================================*/
+
+/*===========================================================================*/
+/* Module local functions.                                                   */
+/*===========================================================================*/
+
+/**
+ * @brief   Designs a section.
+ *
+ * @param[in] sp        pointer to the section parameters
+ * @param[in] fs        sampling rate, in mHz
+ * @param[out] c        b0, b1, b2, -a1, -a2 normalized by a0, Q30
+ */
+static void biquad_design(const BiquadSection *sp, uint32_t fs, q31_t c[5])
+{
+  q31_t s, cs;
+  q63_t cos0, alpha, inv, b[3], a[2];
+
+  chDbgCheck((sp->freq < fs / 2U) && (sp->q >= 32768U));
+
+  /* The sin/cos argument is w0 / pi, that is 2 * f / fs.*/
+  arm_sin_cos_q31((q31_t)(((uint64_t)sp->freq << 32) / fs), &s, &cs);
+  cos0 = cs >> 1;
+  alpha = ((q63_t)s << 14) / sp->q;
+  inv = (BIQUAD_ONE << 30) / (BIQUAD_ONE + alpha);
+
+  if (sp->type == BIQUAD_NOTCH)
+  {
+    b[0] = BIQUAD_ONE;
+    b[1] = -2 * cos0;
+    b[2] = BIQUAD_ONE;
+  }
+  else
+  {
+    b[0] = (BIQUAD_ONE - cos0) / 2;
+    b[1] = BIQUAD_ONE - cos0;
+    b[2] = (BIQUAD_ONE - cos0) / 2;
+  }
+  a[0] = 2 * cos0;
+  a[1] = alpha - BIQUAD_ONE;
+
+  c[0] = clip_q63_to_q31((b[0] * inv) >> 30);
+  c[1] = clip_q63_to_q31((b[1] * inv) >> 30);
+  c[2] = clip_q63_to_q31((b[2] * inv) >> 30);
+  c[3] = clip_q63_to_q31((a[0] * inv) >> 30);
+  c[4] = clip_q63_to_q31((a[1] * inv) >> 30);
+}
+
+/*===========================================================================*/
+/* Module exported functions.                                                */
+/*===========================================================================*/
+
+/**
+ * @brief   Initializes a cascade.
+ *
+ * @param[out] bqp      pointer to the @p Biquad object
+ * @param[in] config    pointer to the cascade configuration
+ *
+ * @api
+ */
+void biquadInit(Biquad *bqp, const BiquadConfig *config)
+{
+  unsigned i;
+
+  chDbgCheck((config->nsections > 0) &&
+             (config->nsections <= BIQUAD_MAX_SECTIONS));
+
+  bqp->fs = config->fs;
+  for (i = 0; i < config->nsections; i++)
+  {
+    bqp->sections[i] = config->sections[i];
+    biquad_design(&bqp->sections[i], bqp->fs, &bqp->coeffs[0][5 * i]);
+  }
+  bqp->pending = false;
+  arm_biquad_cascade_df1_init_q31(&bqp->inst, (uint8_t)config->nsections,
+                                  bqp->coeffs[0], bqp->state, 1);
+}
+
+/**
+ * @brief   Clears the state of a cascade.
+ *
+ * @param[in] bqp       pointer to the @p Biquad object
+ *
+ * @api
+ */
+void biquadReset(Biquad *bqp)
+{
+  unsigned i;
+
+  for (i = 0; i < 4 * BIQUAD_MAX_SECTIONS; i++)
+    bqp->state[i] = 0;
+}
+
+/**
+ * @brief   Filters a block of samples.
+ * @note    A retune is applied at the start of the block.
+ *
+ * @param[in] bqp       pointer to the @p Biquad object
+ * @param[in] in        input samples
+ * @param[out] out      output samples, can be the same buffer as @p in
+ * @param[in] n         number of samples
+ *
+ * @api
+ */
+void biquadProcess(Biquad *bqp, const q31_t *in, q31_t *out, size_t n)
+{
+  chSysLock();
+  if (bqp->pending)
+  {
+    bqp->inst.pCoeffs = bqp->inst.pCoeffs == bqp->coeffs[0] ? bqp->coeffs[1]
+                                                            : bqp->coeffs[0];
+    bqp->pending = false;
+  }
+  chSysUnlock();
+
+  arm_biquad_cascade_df1_q31(&bqp->inst, (q31_t *)in, out, (uint32_t)n);
+}
+
+/**
+ * @brief   Moves a section to a new frequency.
+ * @details The new coefficients are designed in the spare set, the block
+ *          being processed keeps the old ones. Meant for tracking a
+ *          resonance from another thread.
+ *
+ * @param[in] bqp       pointer to the @p Biquad object
+ * @param[in] index     section index
+ * @param[in] freq      new frequency, in mHz
+ * @param[in] q         new quality factor, Q16
+ *
+ * @api
+ */
+void biquadRetune(Biquad *bqp, unsigned index, uint32_t freq, uint32_t q)
+{
+  BiquadSection section;
+  q31_t c[5], *spare;
+  unsigned i;
+
+  chDbgCheck(index < bqp->inst.numStages);
+
+  section.type = bqp->sections[index].type;
+  section.freq = freq;
+  section.q = q;
+  biquad_design(&section, bqp->fs, c);
+
+  chSysLock();
+  if (bqp->inst.pCoeffs == bqp->coeffs[0])
+    spare = bqp->coeffs[1];
+  else
+    spare = bqp->coeffs[0];
+
+  /* A pending set already holds the previous retunes.*/
+  if (!bqp->pending)
+  {
+    for (i = 0; i < 5 * bqp->inst.numStages; i++)
+      spare[i] = bqp->inst.pCoeffs[i];
+  }
+  for (i = 0; i < 5; i++)
+    spare[5 * index + i] = c[i];
+  bqp->sections[index] = section;
+  bqp->pending = true;
+  chSysUnlock();
+}
+
+/** @} */
@@ -0,0 +1,117 @@
+/**
+ * @file    biquad.h
+ * @brief   Low-pass and notch biquad filter cascades.
+ *
+ * @addtogroup BIQUAD
+ * @{
+ */
+
+#ifndef BIQUAD_H
+#define BIQUAD_H
+
+#include "ch.h"
+#include "arm_math.h"
+
+/*===========================================================================*/
+/* Module constants.                                                         */
+/*===========================================================================*/
+
+/**
+ * @name    Section types
+ * @{
+ */
+#define BIQUAD_LOWPASS 0 /**< @brief Second order low-pass.           */
+#define BIQUAD_NOTCH 1   /**< @brief Notch.                           */
+/** @} */
+
+/*===========================================================================*/
+/* Module pre-compile time settings.                                         */
+/*===========================================================================*/
+
+/**
+ * @brief   Largest number of sections in a cascade.
+ */
+#if !defined(BIQUAD_MAX_SECTIONS) || defined(__DOXYGEN__)
+#define BIQUAD_MAX_SECTIONS 4
+#endif
+
+/*===========================================================================*/
+/* Derived constants and error checks.                                       */
+/*===========================================================================*/
+
+/*===========================================================================*/
+/* Module data structures and types.                                         */
+/*===========================================================================*/
+
+/**
+ * @brief   Section design parameters.
+ */
+typedef struct
+{
+  uint32_t type; /**< @brief One of the @p BIQUAD_* section types.      */
+  uint32_t freq; /**< @brief Cutoff or notch frequency, in mHz.         */
+  uint32_t q;    /**< @brief Quality factor, Q16, at least 0.5.         */
+} BiquadSection;
+
+/**
+ * @brief   Cascade configuration.
+ */
+typedef struct
+{
+  uint32_t fs;                     /**< @brief Sampling rate, in mHz.   */
+  unsigned nsections;              /**< @brief Number of sections.      */
+  BiquadSection sections[BIQUAD_MAX_SECTIONS]; /**< @brief Sections in
+                                                           cascade order. */
+} BiquadConfig;
+
+/**
+ * @brief   Cascade object.
+ * @details Coefficients are double buffered, a retune designs the spare
+ *          set and the processing switches to it at the next block.
+ */
+typedef struct
+{
+  arm_biquad_casd_df1_inst_q31 inst;         /**< @brief CMSIS instance. */
+  uint32_t fs;                               /**< @brief Sampling rate.  */
+  BiquadSection sections[BIQUAD_MAX_SECTIONS]; /**< @brief Current
+                                                           design.       */
+  q31_t coeffs[2][5 * BIQUAD_MAX_SECTIONS];  /**< @brief Coefficients.   */
+  q31_t state[4 * BIQUAD_MAX_SECTIONS];      /**< @brief Filter state.   */
+  bool pending;                              /**< @brief Spare set ready. */
+} Biquad;
+
+/*===========================================================================*/
+/* Module macros.                                                            */
+/*===========================================================================*/
+
+/**
+ * @brief   Quality factor constant to Q16.
+ * @note    Meant for constant expressions only.
+ *
+ * @param[in] x         quality factor
+ */
+#define BIQUAD_Q(x) ((uint32_t)((x) * 65536.0))
+
+/*===========================================================================*/
+/* External declarations.                                                    */
+/*===========================================================================*/
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+  void biquadInit(Biquad *bqp, const BiquadConfig *config);
+  void biquadReset(Biquad *bqp);
+  void biquadProcess(Biquad *bqp, const q31_t *in, q31_t *out, size_t n);
+  void biquadRetune(Biquad *bqp, unsigned index, uint32_t freq, uint32_t q);
+#ifdef __cplusplus
+}
+#endif
+
+/*===========================================================================*/
+/* Module inline functions.                                                  */
+/*===========================================================================*/
+
+#endif /* BIQUAD_H */
+
+/** @} */
@@ -0,0 +1,8 @@
+# Biquad filter files.
+BIQUADSRC = $(COREDIR)/src/biquad/biquad.c
+
+BIQUADINC = $(COREDIR)/src/biquad
+
+# Shared variables
+ALLCSRC += $(BIQUADSRC)
+ALLINC  += $(BIQUADINC)
@@ -0,0 +1,190 @@
+/**
+ * @file    boot.c
+ * @brief   Staged boot with stage timestamps.
+ * @details The critical path runs first at the priority of @p main(), the
+ *          non critical stages run afterwards on the same thread lowered
+ *          to a background priority, so the control threads started by the
+ *          critical path preempt them and no working area is spent on a
+ *          boot thread. The end of every stage is stamped with the DWT
+ *          cycle counter, started at the top of @p main(), the clock setup
+ *          done before it by the startup code is not counted.
+ *
+ * @addtogroup BOOT
+ * @{
+ */
+
+#include "ch.h"
+#include "hal.h"
+#include "chprintf.h"
+#include "shell.h"
+#include "boot.h"
+
+/*===========================================================================*/
+/* Module local definitions.                                                 */
+/*===========================================================================*/
+
+/*===========================================================================*/
+/* Module exported variables.                                                */
+/*===========================================================================*/
+
+/*===========================================================================*/
+/* Module local types.                                                       */
+/*===========================================================================*/
+
+/*===========================================================================*/
+/* Module local variables.                                                   */
+/*===========================================================================*/
+
+static BootMark boot_marks[BOOT_MAX_MARKS];
+static volatile uint32_t boot_count;
+
+/*===========================================================================*/
+/* Module local functions.                                                   */
+/*===========================================================================*/
+
+static void boot_print_us(BaseSequentialStream *chp, uint32_t cycles)
+{
+  uint32_t us = cycles / (STM32_HCLK / 1000000U);
+
+  chprintf(chp, " %7lu.%03lu", (unsigned long)(us / 1000U),
+           (unsigned long)(us % 1000U));
+}
+
+/*===========================================================================*/
+/* Module exported functions.                                                */
+/*===========================================================================*/
+
+/**
+ * @brief   Starts the stage timestamps.
+ * @details Called first in @p main(), the kernel enables the same counter
+ *          later without clearing it.
+ *
+ * @init
+ */
+void bootInit(void)
+{
+  CoreDebug->DEMCR |= CoreDebug_DEMCR_TRCENA_Msk;
+  DWT->CYCCNT = 0;
+  DWT->CTRL |= DWT_CTRL_CYCCNTENA_Msk;
+  boot_count = 0;
+}
+
+/**
+ * @brief   Records the end of a stage.
+ * @details The slot is claimed with an exclusive access, the critical and
+ *          the deferred stages can record concurrently, before the kernel
+ *          is initialized too.
+ *
+ * @param[in] name      stage name
+ *
+ * @xclass
+ */
+void bootMark(const char *name)
+{
+  uint32_t cycles = DWT->CYCCNT;
+  uint32_t n;
+
+  do
+  {
+    n = __LDREXW((uint32_t *)&boot_count);
+    if (n >= BOOT_MAX_MARKS)
+    {
+      __CLREX();
+      return;
+    }
+  } while (__STREXW(n + 1U, (uint32_t *)&boot_count) != 0U);
+
+  boot_marks[n].name = name;
+  boot_marks[n].cycles = cycles;
+}
+
+/**
+ * @brief   Runs stages and records each of them.
+ *
+ * @param[in] stages    stages in execution order
+ * @param[in] n         number of stages
+ *
+ * @api
+ */
+void bootRun(const BootStage *stages, unsigned n)
+{
+  unsigned i;
+
+  for (i = 0; i < n; i++)
+  {
+    stages[i].init();
+    bootMark(stages[i].name);
+  }
+}
+
+/**
+ * @brief   Runs stages at @p BOOT_DEFER_PRIORITY.
+ * @details The priority of the calling thread is restored afterwards.
+ *
+ * @param[in] stages    stages in execution order
+ * @param[in] n         number of stages
+ *
+ * @api
+ */
+void bootRunDeferred(const BootStage *stages, unsigned n)
+{
+  tprio_t prio = chThdSetPriority(BOOT_DEFER_PRIORITY);
+
+  bootRun(stages, n);
+  (void)chThdSetPriority(prio);
+}
+
+/**
+ * @brief   Recorded stages.
+ *
+ * @param[out] marksp   the stages in completion order
+ * @return              The number of stages.
+ *
+ * @api
+ */
+unsigned bootGetMarks(const BootMark **marksp)
+{
+  uint32_t n = boot_count;
+
+  *marksp = boot_marks;
+  return n < BOOT_MAX_MARKS ? n : BOOT_MAX_MARKS;
+}
+
+/**
+ * @brief   Shell command listing the stage end times.
+ *
+ * @param[in] chp       pointer to the shell stream
+ * @param[in] argc      number of arguments
+ * @param[in] argv      arguments
+ *
+ * @api
+ */
+void bootCmd(BaseSequentialStream *chp, int argc, char *argv[])
+{
+  const BootMark *marks;
+  unsigned i, n;
+  uint32_t prev = 0;
+
+  (void)argv;
+  if (argc > 0)
+  {
+    shellUsage(chp, "boot");
+    return;
+  }
+
+  n = bootGetMarks(&marks);
+  chprintf(chp, "%-12s %11s %11s" SHELL_NEWLINE_STR, "stage", "end ms",
+           "length ms");
+  for (i = 0; i < n; i++)
+  {
+    chprintf(chp, "%-12s", marks[i].name);
+    boot_print_us(chp, marks[i].cycles);
+    boot_print_us(chp, marks[i].cycles - prev);
+    chprintf(chp, SHELL_NEWLINE_STR);
+    prev = marks[i].cycles;
+  }
+}
+
+SHELL_COMMAND(boot, bootCmd);
+
+/** @} */
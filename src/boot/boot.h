@@ -0,0 +1,92 @@
+/**
+ * @file    boot.h
+ * @brief   Staged boot with stage timestamps.
+ *
+ * @addtogroup BOOT
+ * @{
+ */
+
+#ifndef BOOT_H
+#define BOOT_H
+
+#include "ch.h"
+#include "hal.h"
+
+/*===========================================================================*/
+/* Module constants.                                                         */
+/*===========================================================================*/
+
+/*===========================================================================*/
+/* Module pre-compile time settings.                                         */
+/*===========================================================================*/
+
+/**
+ * @brief   Largest number of recorded stages.
+ */
+#if !defined(BOOT_MAX_MARKS) || defined(__DOXYGEN__)
+#define BOOT_MAX_MARKS 16
+#endif
+
+/**
+ * @brief   Priority of the deferred stages.
+ */
+#if !defined(BOOT_DEFER_PRIORITY) || defined(__DOXYGEN__)
+#define BOOT_DEFER_PRIORITY (LOWPRIO + 1)
+#endif
+
+/*===========================================================================*/
+/* Derived constants and error checks.                                       */
+/*===========================================================================*/
+
+/*===========================================================================*/
+/* Module data structures and types.                                         */
+/*===========================================================================*/
+
+/**
+ * @brief   Boot stage.
+ */
+typedef struct
+{
+  const char *name;     /**< @brief Stage name.                         */
+  void (*init)(void);   /**< @brief Stage function.                     */
+} BootStage;
+
+/**
+ * @brief   Recorded stage end.
+ */
+typedef struct
+{
+  const char *name;     /**< @brief Stage name.                         */
+  uint32_t cycles;      /**< @brief Core clock cycles since
+                                    @p bootInit().                      */
+} BootMark;
+
+/*===========================================================================*/
+/* Module macros.                                                            */
+/*===========================================================================*/
+
+/*===========================================================================*/
+/* External declarations.                                                    */
+/*===========================================================================*/
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+  void bootInit(void);
+  void bootMark(const char *name);
+  void bootRun(const BootStage *stages, unsigned n);
+  void bootRunDeferred(const BootStage *stages, unsigned n);
+  unsigned bootGetMarks(const BootMark **marksp);
+  void bootCmd(BaseSequentialStream *chp, int argc, char *argv[]);
+#ifdef __cplusplus
+}
+#endif
+
+/*===========================================================================*/
+/* Module inline functions.                                                  */
+/*===========================================================================*/
+
+#endif /* BOOT_H */
+
+/** @} */
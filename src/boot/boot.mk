@@ -0,0 +1,8 @@
+# Staged boot files.
+BOOTSRC = $(COREDIR)/src/boot/boot.c
+
+BOOTINC = $(COREDIR)/src/boot
+
+# Shared variables
+ALLCSRC += $(BOOTSRC)
+ALLINC  += $(BOOTINC)
@@ -0,0 +1,425 @@
+/**
+ * @file    channel.hpp
+ * @brief   Typed, allocation-free channel templates.
+ * @details Thin typed layers over the objects FIFO and a sequence lock.
+ *          Storage is reserved inside the objects, every method is inline
+ *          and non-virtual, so a call compiles to the same code as the C
+ *          API with the casts written by hand.
+ *
+ * @addtogroup CHANNEL
+ * @{
+ */
+
+#ifndef CHANNEL_HPP
+#define CHANNEL_HPP
+
+#include <stddef.h>
+#include <stdint.h>
+#include <type_traits>
+
+#include "ch.hpp"
+#include "hal.h"
+
+#if (CH_CFG_USE_OBJ_FIFOS == FALSE) && !defined(__DOXYGEN__)
+#error "channel.hpp requires CH_CFG_USE_OBJ_FIFOS"
+#endif
+
+/**
+ * @brief   Typed channels.
+ */
+namespace channel {
+
+  /*------------------------------------------------------------------------*
+   * channel::ObjectFifo                                                    *
+   *------------------------------------------------------------------------*/
+  /**
+   * @brief   Objects FIFO of @p N objects of type @p T.
+   * @details Zero-copy: the producer takes a free object, fills it and
+   *          sends it, the consumer receives it and returns it when done.
+   *
+   * @param T               object type, trivially copyable
+   * @param N               number of objects
+   */
+  template <typename T, size_t N>
+  class ObjectFifo {
+
+    static_assert(N > 0, "ObjectFifo needs at least one object");
+    static_assert(std::is_trivially_copyable<T>::value,
+                  "ObjectFifo objects must be trivially copyable");
+
+  public:
+    /**
+     * @brief   Number of objects.
+     */
+    static constexpr size_t capacity = N;
+
+    /**
+     * @brief   Object alignment, at least the one of the free list.
+     */
+    static constexpr size_t align = alignof(T) > PORT_NATURAL_ALIGN
+                                        ? alignof(T)
+                                        : PORT_NATURAL_ALIGN;
+
+    /**
+     * @brief   Storage of one object, it also holds a free list link.
+     */
+    static constexpr size_t slot =
+        ((sizeof(T) > sizeof(void *) ? sizeof(T) : sizeof(void *)) +
+         align - 1U) / align * align;
+
+  private:
+    objects_fifo_t fifo;
+    alignas(align) uint8_t objs[slot * N];
+    msg_t msgs[N];
+
+  public:
+    /**
+     * @brief   ObjectFifo constructor.
+     * @details The free list is linked by hand and the pool semaphore
+     *          set to @p N instead of loading the pool object by object,
+     *          which would lock and reschedule. No kernel service is
+     *          called, so a namespace-scope FIFO can be constructed
+     *          before @p chSysInit().
+     *
+     * @init
+     */
+    ObjectFifo(void) {
+
+      chGuardedPoolObjectInitAligned(&fifo.free, slot, align);
+      for (size_t i = 0U; i < N; i++) {
+        struct pool_header *php =
+            reinterpret_cast<struct pool_header *>(&objs[i * slot]);
+
+        php->next = i + 1U < N
+                        ? reinterpret_cast<struct pool_header *>(
+                              &objs[(i + 1U) * slot])
+                        : nullptr;
+      }
+      fifo.free.pool.next = reinterpret_cast<struct pool_header *>(objs);
+      chSemObjectInit(&fifo.free.sem, static_cast<cnt_t>(N));
+      chMBObjectInit(&fifo.mbx, msgs, N);
+    }
+
+    ObjectFifo(const ObjectFifo &) = delete;
+    ObjectFifo &operator=(const ObjectFifo &) = delete;
+
+    /**
+     * @brief   Takes a free object.
+     *
+     * @return              The object, @p nullptr if none is free.
+     *
+     * @iclass
+     */
+    T *takeObjectI(void) {
+
+      return static_cast<T *>(chFifoTakeObjectI(&fifo));
+    }
+
+    /**
+     * @brief   Takes a free object, waiting for one.
+     *
+     * @param[in] timeout   the number of ticks before the operation timeouts
+     * @return              The object, @p nullptr on timeout.
+     *
+     * @api
+     */
+    T *takeObjectTimeout(sysinterval_t timeout) {
+
+      return static_cast<T *>(chFifoTakeObjectTimeout(&fifo, timeout));
+    }
+
+    /**
+     * @brief   Returns an object to the free ones.
+     *
+     * @param[in] objp      the object
+     *
+     * @iclass
+     */
+    void returnObjectI(T *objp) {
+
+      chFifoReturnObjectI(&fifo, objp);
+    }
+
+    /**
+     * @brief   Returns an object to the free ones.
+     *
+     * @param[in] objp      the object
+     *
+     * @api
+     */
+    void returnObject(T *objp) {
+
+      chFifoReturnObject(&fifo, objp);
+    }
+
+    /**
+     * @brief   Sends a filled object.
+     *
+     * @param[in] objp      the object, taken from this FIFO
+     *
+     * @iclass
+     */
+    void sendObjectI(T *objp) {
+
+      chFifoSendObjectI(&fifo, objp);
+    }
+
+    /**
+     * @brief   Sends a filled object.
+     *
+     * @param[in] objp      the object, taken from this FIFO
+     *
+     * @api
+     */
+    void sendObject(T *objp) {
+
+      chFifoSendObject(&fifo, objp);
+    }
+
+    /**
+     * @brief   Receives an object.
+     *
+     * @param[out] objp     the object
+     * @return              The operation status.
+     * @retval MSG_OK       if an object was received.
+     * @retval MSG_TIMEOUT  if the FIFO was empty.
+     *
+     * @iclass
+     */
+    msg_t receiveObjectI(T *&objp) {
+
+      return chFifoReceiveObjectI(&fifo, reinterpret_cast<void **>(&objp));
+    }
+
+    /**
+     * @brief   Receives an object, waiting for one.
+     *
+     * @param[out] objp     the object
+     * @param[in] timeout   the number of ticks before the operation timeouts
+     * @return              The operation status.
+     * @retval MSG_OK       if an object was received.
+     * @retval MSG_TIMEOUT  if the operation timed out.
+     *
+     * @api
+     */
+    msg_t receiveObjectTimeout(T *&objp, sysinterval_t timeout) {
+
+      return chFifoReceiveObjectTimeout(&fifo,
+                                        reinterpret_cast<void **>(&objp),
+                                        timeout);
+    }
+  };
+
+  /*------------------------------------------------------------------------*
+   * channel::Mailbox                                                       *
+   *------------------------------------------------------------------------*/
+  /**
+   * @brief   Mailbox of @p N messages of type @p T, by value.
+   * @details Unlike @p chibios_rt::Mailbox the messages are not limited
+   *          to the size of a @p msg_t, each one is copied once in and
+   *          once out of an objects FIFO.
+   *
+   * @param T               message type, trivially copyable
+   * @param N               number of messages
+   */
+  template <typename T, size_t N>
+  class Mailbox {
+    ObjectFifo<T, N> fifo;
+
+  public:
+    /**
+     * @brief   Number of messages.
+     */
+    static constexpr size_t capacity = N;
+
+    /**
+     * @brief   Posts a message.
+     *
+     * @param[in] msg       the message
+     * @return              The message was posted, the mailbox was full
+     *                      otherwise.
+     *
+     * @iclass
+     */
+    bool postI(const T &msg) {
+      T *objp = fifo.takeObjectI();
+
+      if (objp == nullptr) {
+        return false;
+      }
+      *objp = msg;
+      fifo.sendObjectI(objp);
+      return true;
+    }
+
+    /**
+     * @brief   Posts a message, waiting for room.
+     *
+     * @param[in] msg       the message
+     * @param[in] timeout   the number of ticks before the operation timeouts
+     * @return              The operation status.
+     * @retval MSG_OK       if the message was posted.
+     * @retval MSG_TIMEOUT  if the operation timed out.
+     *
+     * @api
+     */
+    msg_t post(const T &msg, sysinterval_t timeout) {
+      T *objp = fifo.takeObjectTimeout(timeout);
+
+      if (objp == nullptr) {
+        return MSG_TIMEOUT;
+      }
+      *objp = msg;
+      fifo.sendObject(objp);
+      return MSG_OK;
+    }
+
+    /**
+     * @brief   Fetches a message.
+     *
+     * @param[out] msg      the message
+     * @return              The operation status.
+     * @retval MSG_OK       if a message was fetched.
+     * @retval MSG_TIMEOUT  if the mailbox was empty.
+     *
+     * @iclass
+     */
+    msg_t fetchI(T &msg) {
+      T *objp;
+      msg_t rdy = fifo.receiveObjectI(objp);
+
+      if (rdy == MSG_OK) {
+        msg = *objp;
+        fifo.returnObjectI(objp);
+      }
+      return rdy;
+    }
+
+    /**
+     * @brief   Fetches a message, waiting for one.
+     *
+     * @param[out] msg      the message
+     * @param[in] timeout   the number of ticks before the operation timeouts
+     * @return              The operation status.
+     * @retval MSG_OK       if a message was fetched.
+     * @retval MSG_TIMEOUT  if the operation timed out.
+     *
+     * @api
+     */
+    msg_t fetch(T &msg, sysinterval_t timeout) {
+      T *objp;
+      msg_t rdy = fifo.receiveObjectTimeout(objp, timeout);
+
+      if (rdy == MSG_OK) {
+        msg = *objp;
+        fifo.returnObject(objp);
+      }
+      return rdy;
+    }
+  };
+
+  /*------------------------------------------------------------------------*
+   * channel::LatestValue                                                   *
+   *------------------------------------------------------------------------*/
+  /**
+   * @brief   Latest value of type @p T behind a sequence lock.
+   * @details A single writer, from any context, never waits. Readers never
+   *          lock and retry when a write overlapped their copy.
+   * @note    A reader spins until the write it overlapped completes, so it
+   *          must never preempt the writer: with a thread writer, readers
+   *          are threads only, an ISR reader spinning over a preempted
+   *          write never returns.
+   *
+   * @param T               value type, trivially copyable
+   */
+  template <typename T>
+  class LatestValue {
+
+    static_assert(std::is_trivially_copyable<T>::value,
+                  "LatestValue type must be trivially copyable");
+
+    volatile uint32_t seq;
+    T value;
+
+  public:
+    /**
+     * @brief   LatestValue constructor.
+     *
+     * @param[in] init      initial value
+     *
+     * @init
+     */
+    constexpr explicit LatestValue(const T &init = T()) :
+      seq(0), value(init) {
+    }
+
+    LatestValue(const LatestValue &) = delete;
+    LatestValue &operator=(const LatestValue &) = delete;
+
+    /**
+     * @brief   Writes a new value.
+     *
+     * @param[in] v         the value
+     *
+     * @xclass
+     */
+    void write(const T &v) {
+
+      seq = seq + 1U;
+      __DMB();
+      value = v;
+      __DMB();
+      seq = seq + 1U;
+    }
+
+    /**
+     * @brief   Reads the value.
+     *
+     * @param[out] v        the value
+     * @return              The number of writes up to this value.
+     *
+     * @api
+     */
+    uint32_t read(T &v) const {
+      uint32_t s;
+
+      do {
+        s = seq;
+        __DMB();
+        v = value;
+        __DMB();
+      } while (((s & 1U) != 0U) || (s != seq));
+
+      return s / 2U;
+    }
+
+    /**
+     * @brief   Reads the value.
+     *
+     * @return              The value.
+     *
+     * @api
+     */
+    T read(void) const {
+      T v;
+
+      (void)read(v);
+      return v;
+    }
+
+    /**
+     * @brief   Number of writes so far.
+     * @details Tells whether a new value was written since a read.
+     *
+     * @xclass
+     */
+    uint32_t writes(void) const {
+
+      return seq / 2U;
+    }
+  };
+}
+
+#endif /* CHANNEL_HPP */
+
+/** @} */
@@ -0,0 +1,5 @@
+# Typed C++ channel files, header only.
+CHANNELINC = $(COREDIR)/src/channel
+
+# Shared variables
+ALLINC  += $(CHANNELINC)
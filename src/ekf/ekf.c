@@ -0,0 +1,167 @@
+/**
+ * @file    ekf.c
+ * @brief   Q31 extended Kalman filter.
+ * @details The state transition Jacobian is close to the identity, which
+ *          Q31 cannot represent, so the prediction takes G = F - I and
+ *          expands F P F' into P + G P + (G P)' + G P G' with the CMSIS
+ *          matrix functions. Measurements with uncorrelated noise are
+ *          applied one row at a time, the innovation covariance is then a
+ *          scalar and the gain needs no matrix inversion. Each row is
+ *          sparse, only the covariance columns of its non-zero terms are
+ *          read to build P H'.
+ *
+ * @addtogroup EKF
+ * @{
+ */
+
+#include "ch.h"
+#include "ekf.h"
+
+/*===========================================================================*/
+/* Module local definitions.                                                 */
+/*===========================================================================*/
+
+/*===========================================================================*/
+/* Module exported variables.                                                */
+/*===========================================================================*/
+
+/*===========================================================================*/
+/* Module local types.                                                       */
+/*===========================================================================*/
+
+/*===========================================================================*/
+/* Module local variables.                                                   */
+/*===========================================================================*/
+
+/*===========================================================================*/
+/* Module local functions.                                                   */
+/*===========================================================================*/
+
+/*===========================================================================*/
+/* Module exported functions.                                                */
+/*===========================================================================*/
+
+/**
+ * @brief   Initializes a filter.
+ *
+ * @param[out] ekfp     pointer to the @p Ekf object
+ * @param[in] n         number of states
+ * @param[in] x0        initial state
+ * @param[in] p0        initial covariance diagonal
+ *
+ * @api
+ */
+void ekfInit(Ekf *ekfp, unsigned n, const q31_t *x0, const q31_t *p0)
+{
+  unsigned i;
+
+  chDbgCheck((n > 0) && (n <= EKF_MAX_STATES));
+
+  ekfp->n = n;
+  for (i = 0; i < n * n; i++)
+    ekfp->p[i] = 0;
+  for (i = 0; i < n; i++)
+  {
+    ekfp->x[i] = x0[i];
+    ekfp->p[i * n + i] = p0[i];
+  }
+}
+
+/**
+ * @brief   Propagates the covariance.
+ * @note    The caller propagates the state itself, writing f(x, u) into
+ *          @p x, before or after this call.
+ *
+ * @param[in] ekfp      pointer to the @p Ekf object
+ * @param[in] g         state transition Jacobian minus the identity,
+ *                      row-major
+ * @param[in] q         process noise covariance diagonal for this step
+ *
+ * @api
+ */
+void ekfPredict(Ekf *ekfp, q31_t *g, const q31_t *q)
+{
+  arm_matrix_instance_q31 mg, mgt, mp, mgp, mgpt, mgpg;
+  uint16_t n = (uint16_t)ekfp->n;
+  unsigned i;
+
+  arm_mat_init_q31(&mg, n, n, g);
+  arm_mat_init_q31(&mgt, n, n, ekfp->gt);
+  arm_mat_init_q31(&mp, n, n, ekfp->p);
+  arm_mat_init_q31(&mgp, n, n, ekfp->gp);
+  arm_mat_init_q31(&mgpt, n, n, ekfp->gpt);
+  arm_mat_init_q31(&mgpg, n, n, ekfp->gpg);
+
+  (void)arm_mat_trans_q31(&mg, &mgt);
+  (void)arm_mat_mult_q31(&mg, &mp, &mgp);
+  (void)arm_mat_trans_q31(&mgp, &mgpt);
+  (void)arm_mat_mult_q31(&mgp, &mgt, &mgpg);
+
+  (void)arm_mat_add_q31(&mp, &mgp, &mp);
+  (void)arm_mat_add_q31(&mp, &mgpt, &mp);
+  (void)arm_mat_add_q31(&mp, &mgpg, &mp);
+  for (i = 0; i < n; i++)
+    ekfp->p[i * n + i] = clip_q63_to_q31((q63_t)ekfp->p[i * n + i] + q[i]);
+}
+
+/**
+ * @brief   Applies a scalar measurement.
+ *
+ * @param[in] ekfp      pointer to the @p Ekf object
+ * @param[in] h         non-zero terms of the measurement Jacobian row
+ * @param[in] nterms    number of terms
+ * @param[in] innov     innovation, measurement minus h(x)
+ * @param[in] r         measurement noise variance
+ * @return              The measurement was applied.
+ * @retval false        Degenerate innovation covariance.
+ *
+ * @api
+ */
+bool ekfUpdate(Ekf *ekfp, const EkfTerm *h, unsigned nterms, q31_t innov,
+               q31_t r)
+{
+  unsigned n = ekfp->n;
+  q31_t *p = ekfp->p;
+  q31_t pht[EKF_MAX_STATES];
+  q63_t acc, s;
+  unsigned i, j;
+
+  /* P H', only the columns of the non-zero terms.*/
+  for (i = 0; i < n; i++)
+  {
+    acc = 0;
+    for (j = 0; j < nterms; j++)
+      acc += (q63_t)p[i * n + h[j].index] * h[j].value;
+    pht[i] = clip_q63_to_q31(acc >> 31);
+  }
+
+  /* S = H P H' + R, kept in 64 bits.*/
+  s = r;
+  for (j = 0; j < nterms; j++)
+    s += ((q63_t)pht[h[j].index] * h[j].value) >> 31;
+  if (s <= 0)
+    return false;
+
+  for (i = 0; i < n; i++)
+    ekfp->x[i] = clip_q63_to_q31(ekfp->x[i] +
+                                 ((q63_t)pht[i] * innov) / s);
+
+  /* P -= P H' H P / S, symmetric.*/
+  for (i = 0; i < n; i++)
+  {
+    for (j = 0; j <= i; j++)
+    {
+      q31_t v = clip_q63_to_q31(p[i * n + j] -
+                                ((q63_t)pht[i] * pht[j]) / s);
+
+      p[i * n + j] = v;
+      p[j * n + i] = v;
+    }
+    if (p[i * n + i] < 0)
+      p[i * n + i] = 0;
+  }
+
+  return true;
+}
+
+/** @} */
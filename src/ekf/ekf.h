@@ -0,0 +1,90 @@
+/**
+ * @file    ekf.h
+ * @brief   Q31 extended Kalman filter.
+ *
+ * @addtogroup EKF
+ * @{
+ */
+
+#ifndef EKF_H
+#define EKF_H
+
+#include "ch.h"
+#include "arm_math.h"
+
+/*===========================================================================*/
+/* Module constants.                                                         */
+/*===========================================================================*/
+
+/*===========================================================================*/
+/* Module pre-compile time settings.                                         */
+/*===========================================================================*/
+
+/**
+ * @brief   Largest number of states.
+ * @details The filter object holds five matrices of this size.
+ */
+#if !defined(EKF_MAX_STATES) || defined(__DOXYGEN__)
+#define EKF_MAX_STATES 4
+#endif
+
+/*===========================================================================*/
+/* Derived constants and error checks.                                       */
+/*===========================================================================*/
+
+/*===========================================================================*/
+/* Module data structures and types.                                         */
+/*===========================================================================*/
+
+/**
+ * @brief   Non-zero term of a measurement Jacobian row.
+ */
+typedef struct
+{
+  unsigned index; /**< @brief State index.                              */
+  q31_t value;    /**< @brief Partial derivative.                       */
+} EkfTerm;
+
+/**
+ * @brief   Filter object.
+ * @details All the values are Q31 in state units chosen by the user, so
+ *          that states and covariances stay within the Q31 range.
+ */
+typedef struct
+{
+  unsigned n;                                  /**< @brief States.       */
+  q31_t x[EKF_MAX_STATES];                     /**< @brief State.        */
+  q31_t p[EKF_MAX_STATES * EKF_MAX_STATES];    /**< @brief Covariance.   */
+  q31_t gt[EKF_MAX_STATES * EKF_MAX_STATES];   /**< @brief Scratch.      */
+  q31_t gp[EKF_MAX_STATES * EKF_MAX_STATES];   /**< @brief Scratch.      */
+  q31_t gpt[EKF_MAX_STATES * EKF_MAX_STATES];  /**< @brief Scratch.      */
+  q31_t gpg[EKF_MAX_STATES * EKF_MAX_STATES];  /**< @brief Scratch.      */
+} Ekf;
+
+/*===========================================================================*/
+/* Module macros.                                                            */
+/*===========================================================================*/
+
+/*===========================================================================*/
+/* External declarations.                                                    */
+/*===========================================================================*/
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+  void ekfInit(Ekf *ekfp, unsigned n, const q31_t *x0, const q31_t *p0);
+  void ekfPredict(Ekf *ekfp, q31_t *g, const q31_t *q);
+  bool ekfUpdate(Ekf *ekfp, const EkfTerm *h, unsigned nterms, q31_t innov,
+                 q31_t r);
+#ifdef __cplusplus
+}
+#endif
+
+/*===========================================================================*/
+/* Module inline functions.                                                  */
+/*===========================================================================*/
+
+#endif /* EKF_H */
+
+/** @} */
@@ -0,0 +1,8 @@
+# Extended Kalman filter files.
+EKFSRC = $(COREDIR)/src/ekf/ekf.c
+
+EKFINC = $(COREDIR)/src/ekf
+
+# Shared variables
+ALLCSRC += $(EKFSRC)
+ALLINC  += $(EKFINC)
@@ -0,0 +1,72 @@
+/**
+ * @file    fixmath.h
+ * @brief   Fixed-point helpers shared by the estimation and control
+ *          modules.
+ *
+ * @addtogroup FIXMATH
+ * @{
+ */
+
+#ifndef FIXMATH_H
+#define FIXMATH_H
+
+#include "arm_math.h"
+
+/*===========================================================================*/
+/* Module constants.                                                         */
+/*===========================================================================*/
+
+/*===========================================================================*/
+/* Module pre-compile time settings.                                         */
+/*===========================================================================*/
+
+/*===========================================================================*/
+/* Derived constants and error checks.                                       */
+/*===========================================================================*/
+
+/*===========================================================================*/
+/* Module data structures and types.                                         */
+/*===========================================================================*/
+
+/*===========================================================================*/
+/* Module macros.                                                            */
+/*===========================================================================*/
+
+/*===========================================================================*/
+/* External declarations.                                                    */
+/*===========================================================================*/
+
+/*===========================================================================*/
+/* Module inline functions.                                                  */
+/*===========================================================================*/
+
+/**
+ * @brief   Square root of a 64 bits integer.
+ * @details The argument is normalized to the Q31 range with an odd shift
+ *          so that the precision of @p arm_sqrt_q31() is kept for small
+ *          arguments too, a Q60 argument gives a Q30 result.
+ *
+ * @param[in] x         argument
+ * @return              The square root, truncated.
+ */
+static inline uint32_t fixSqrt64(uint64_t x)
+{
+  q31_t r;
+  int e;
+
+  if (x == 0)
+    return 0;
+
+  e = (64 - __builtin_clzll(x)) - 31;
+  if ((e & 1) == 0)
+    e++;
+  (void)arm_sqrt_q31((q31_t)(e >= 0 ? x >> e : x << -e), &r);
+
+  /* sqrt(x) = sqrt(v * 2^31) * 2^((e - 31) / 2).*/
+  e = (e - 31) / 2;
+  return e >= 0 ? (uint32_t)r << e : (uint32_t)r >> -e;
+}
+
+#endif /* FIXMATH_H */
+
+/** @} */
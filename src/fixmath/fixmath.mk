@@ -0,0 +1,5 @@
+# Fixed-point helper files, header only.
+FIXMATHINC = $(COREDIR)/src/fixmath
+
+# Shared variables
+ALLINC  += $(FIXMATHINC)
@@ -0,0 +1,398 @@
+/**
+ * @file    idle.c
+ * @brief   Tickless idle.
+ * @details The idle thread picks the deepest mode that fits before the
+ *          next virtual timer. Short gaps wait for an interrupt with the
+ *          clocks running, longer ones also gate the flash clock. STOP is
+ *          entered only while its worst measured exit time is within the
+ *          latency budget, with the RTC alarm set that exit time ahead of
+ *          the timer, so the timer is never delayed. The system timer
+ *          stops with the clocks, it is frozen on entry and advanced by
+ *          the RTC count on exit, along with the cycle counter.
+ *
+ * @addtogroup IDLE
+ * @{
+ */
+
+#include "ch.h"
+#include "hal.h"
+#include "chprintf.h"
+#include "shell.h"
+#include "idle.h"
+
+/*===========================================================================*/
+/* Module local definitions.                                                 */
+/*===========================================================================*/
+
+#define IDLE_RTC_HANDLER VectorE4
+
+/**
+ * @brief   RTC prescaler reload, the counter runs at half the LSI rate.
+ */
+#define IDLE_RTC_PRL 1U
+
+/**
+ * @brief   Shortest alarm distance in RTC ticks.
+ * @details Covers the write of the alarm registers.
+ */
+#define IDLE_RTC_MIN_TICKS 8U
+
+/**
+ * @brief   LSI calibration window, ms.
+ */
+#define IDLE_CAL_MS 100
+
+/**
+ * @brief   Longest STOP in system ticks, well within the counter range.
+ */
+#define IDLE_STOP_MAX_TICKS ((sysinterval_t)1 << (CH_CFG_ST_RESOLUTION - 2))
+
+/*===========================================================================*/
+/* Module exported variables.                                                */
+/*===========================================================================*/
+
+/*===========================================================================*/
+/* Module local types.                                                       */
+/*===========================================================================*/
+
+/*===========================================================================*/
+/* Module local variables.                                                   */
+/*===========================================================================*/
+
+static const char *const idle_names[IDLE_NUM_MODES] = {"wfi", "sleep",
+                                                       "stop"};
+
+static IdleStats idle_stats = {.stop_exit_us = IDLE_STOP_EXIT_US};
+
+/**
+ * @brief   STOP exit time measured at least once.
+ */
+static bool idle_measured;
+
+/**
+ * @brief   Fraction of a system tick left over by the last STOP.
+ */
+static uint32_t idle_frac;
+
+/*===========================================================================*/
+/* Module local functions.                                                   */
+/*===========================================================================*/
+
+static uint32_t rtc_count(void)
+{
+  uint16_t h, l;
+
+  do
+  {
+    h = RTC->CNTH;
+    l = RTC->CNTL;
+  } while (h != RTC->CNTH);
+
+  return ((uint32_t)h << 16) | l;
+}
+
+/**
+ * @brief   Waits for the RTC registers after the APB1 clock was stopped.
+ */
+static void rtc_sync(void)
+{
+  RTC->CRL &= ~RTC_CRL_RSF;
+  while ((RTC->CRL & RTC_CRL_RSF) == 0)
+    ;
+}
+
+static void rtc_write_begin(void)
+{
+  while ((RTC->CRL & RTC_CRL_RTOFF) == 0)
+    ;
+  RTC->CRL |= RTC_CRL_CNF;
+}
+
+static void rtc_write_end(void)
+{
+  RTC->CRL &= ~RTC_CRL_CNF;
+  while ((RTC->CRL & RTC_CRL_RTOFF) == 0)
+    ;
+}
+
+/**
+ * @brief   Waits for the next RTC tick.
+ *
+ * @param[out] cycles   cycle counter at the tick
+ * @return              The RTC count.
+ */
+static uint32_t rtc_edge(uint32_t *cycles)
+{
+  uint32_t c;
+
+  chSysLock();
+  c = rtc_count();
+  while (rtc_count() == c)
+    ;
+  *cycles = DWT->CYCCNT;
+  chSysUnlock();
+
+  return c + 1U;
+}
+
+static uint32_t idle_ticks_to_us(uint32_t n)
+{
+  return (uint32_t)((uint64_t)n * 1000000U / idle_stats.rtc_hz);
+}
+
+/**
+ * @brief   Time to the next virtual timer.
+ * @details One tick short, the current tick is partly elapsed.
+ *
+ * @return              The time in us.
+ */
+static uint32_t idle_next_us(void)
+{
+  sysinterval_t left = IDLE_STOP_MAX_TICKS;
+
+  if (ch.vtlist.next != (virtual_timer_t *)&ch.vtlist)
+  {
+    sysinterval_t elapsed =
+        chTimeDiffX(ch.vtlist.lasttime, chVTGetSystemTimeX());
+    sysinterval_t delta = ch.vtlist.next->delta;
+
+    left = elapsed < delta ? delta - elapsed : 0;
+    if (left > IDLE_STOP_MAX_TICKS)
+      left = IDLE_STOP_MAX_TICKS;
+  }
+
+  return left > 0 ? (uint32_t)TIME_I2US(left - 1) : 0U;
+}
+
+/**
+ * @brief   Enters STOP until the RTC alarm or any other interrupt.
+ *
+ * @param[in] us        time to the next virtual timer
+ * @return              STOP was entered.
+ */
+static bool idle_stop(uint32_t us)
+{
+  stm32_tim_t *tim = STM32_ST_TIM;
+  uint32_t n, alarm, c0, ticks, cycles, run, t0;
+  systime_t cnt, adv;
+  bool woken, late;
+
+  if (us < idle_stats.stop_exit_us)
+    return false;
+  n = (uint32_t)((uint64_t)(us - idle_stats.stop_exit_us) *
+                 idle_stats.rtc_hz / 1000000U);
+  if (n < IDLE_RTC_MIN_TICKS)
+    return false;
+
+  /* Alarm ahead of the timer by the exit time.*/
+  alarm = rtc_count() + n;
+  rtc_write_begin();
+  RTC->ALRH = (uint16_t)(alarm >> 16);
+  RTC->ALRL = (uint16_t)alarm;
+  rtc_write_end();
+
+  /* System time frozen from here, advanced by the RTC on exit.*/
+  tim->CR1 &= ~STM32_TIM_CR1_CEN;
+  c0 = rtc_count();
+  if ((int32_t)(alarm - c0) < 2)
+  {
+    tim->CR1 |= STM32_TIM_CR1_CEN;
+    return false;
+  }
+  RTC->CRL &= ~RTC_CRL_ALRF;
+  EXTI->PR = EXTI_PR_PR17;
+
+  t0 = DWT->CYCCNT;
+  PWR->CR &= ~(PWR_CR_PDDS | PWR_CR_LPDS);
+  SCB->SCR |= SCB_SCR_SLEEPDEEP_Msk;
+  __DSB();
+  __WFI();
+  SCB->SCR &= ~SCB_SCR_SLEEPDEEP_Msk;
+  woken = (EXTI->PR & EXTI_PR_PR17) != 0;
+
+  /* Running on the HSI, the PLL is restarted and the RTC registers are
+     only valid again after a resynchronization.*/
+  stm32_clock_init();
+  rtc_sync();
+  ticks = rtc_count() - c0;
+
+  /* Exit time from the alarm to the restored clocks.*/
+  if (woken)
+  {
+    uint32_t exit_us = idle_ticks_to_us(c0 + ticks - alarm + 1U);
+
+    if (!idle_measured || exit_us > idle_stats.stop_exit_us)
+      idle_stats.stop_exit_us = exit_us;
+    idle_measured = true;
+  }
+
+  /* System ticks asleep, the remainder is carried to the next STOP.*/
+  idle_frac += ticks * CH_CFG_ST_FREQUENCY;
+  adv = (systime_t)(idle_frac / idle_stats.rtc_hz);
+  idle_frac %= idle_stats.rtc_hz;
+  cnt = (systime_t)tim->CNT;
+  late = st_lld_is_alarm_active() &&
+         (systime_t)(st_lld_get_alarm() - cnt - 1U) < adv;
+  tim->CNT = (systime_t)(cnt + adv);
+  tim->CR1 |= STM32_TIM_CR1_CEN;
+  if (late)
+    tim->EGR = STM32_TIM_EGR_CC1G;
+
+  /* The cycle counter only ran on the way out.*/
+  cycles = (uint32_t)((uint64_t)ticks * STM32_HCLK / idle_stats.rtc_hz);
+  run = DWT->CYCCNT - t0;
+  if (cycles > run)
+    DWT->CYCCNT += cycles - run;
+
+  idle_stats.mode[IDLE_STOP].entries++;
+  idle_stats.mode[IDLE_STOP].cycles += cycles;
+  return true;
+}
+
+/*===========================================================================*/
+/* Module interrupt handlers.                                                */
+/*===========================================================================*/
+
+/**
+ * @brief   RTC alarm through EXTI line 17, only there to end STOP.
+ *
+ * @isr
+ */
+OSAL_IRQ_HANDLER(IDLE_RTC_HANDLER)
+{
+  OSAL_IRQ_PROLOGUE();
+
+  RTC->CRL &= ~RTC_CRL_ALRF;
+  EXTI->PR = EXTI_PR_PR17;
+
+  OSAL_IRQ_EPILOGUE();
+}
+
+/*===========================================================================*/
+/* Module exported functions.                                                */
+/*===========================================================================*/
+
+/**
+ * @brief   Starts the RTC on the LSI and calibrates it.
+ * @details STOP stays off until this returns. The backup domain is reset
+ *          if the RTC was clocked from another source.
+ *
+ * @api
+ */
+void idleInit(void)
+{
+  uint32_t c0, c1, t0, t1;
+
+  if ((RCC->BDCR & RCC_BDCR_RTCSEL) != RCC_BDCR_RTCSEL_LSI)
+  {
+    RCC->BDCR = RCC_BDCR_BDRST;
+    RCC->BDCR = 0;
+    RCC->BDCR = RCC_BDCR_RTCSEL_LSI;
+  }
+  RCC->BDCR |= RCC_BDCR_RTCEN;
+  rtc_sync();
+  rtc_write_begin();
+  RTC->PRLH = 0;
+  RTC->PRLL = IDLE_RTC_PRL;
+  rtc_write_end();
+  RTC->CRH = RTC_CRH_ALRIE;
+
+  EXTI->IMR |= EXTI_IMR_MR17;
+  EXTI->RTSR |= EXTI_RTSR_TR17;
+  nvicEnableVector(RTC_Alarm_IRQn, IDLE_RTC_IRQ_PRIORITY);
+
+  /* The LSI is only specified within 30 to 60 kHz.*/
+  c0 = rtc_edge(&t0);
+  chThdSleepMilliseconds(IDLE_CAL_MS);
+  c1 = rtc_edge(&t1);
+
+  chSysLock();
+  idle_stats.rtc_hz = (uint32_t)((uint64_t)(c1 - c0) * STM32_HCLK / (t1 - t0));
+  chSysUnlock();
+}
+
+/**
+ * @brief   Idles until the next interrupt.
+ * @details Called by the idle thread loop.
+ *
+ * @special
+ */
+void idleSleep(void)
+{
+  uint32_t us, t0;
+  unsigned mode;
+
+  __disable_irq();
+
+  us = idle_next_us();
+  if (idle_stats.rtc_hz == 0U ||
+      idle_stats.stop_exit_us > IDLE_LATENCY_BUDGET_US || !idle_stop(us))
+  {
+    /* The flash interface clock stops in sleep, SRAM is kept for DMA.*/
+    mode = us >= IDLE_SLEEP_MIN_US ? IDLE_SLEEP : IDLE_WFI;
+    t0 = DWT->CYCCNT;
+    if (mode == IDLE_SLEEP)
+      RCC->AHBENR &= ~RCC_AHBENR_FLITFEN;
+    __DSB();
+    __WFI();
+    RCC->AHBENR |= RCC_AHBENR_FLITFEN;
+
+    idle_stats.mode[mode].entries++;
+    idle_stats.mode[mode].cycles += DWT->CYCCNT - t0;
+  }
+
+  __enable_irq();
+}
+
+/**
+ * @brief   Idle statistics.
+ *
+ * @param[out] sp       the statistics
+ *
+ * @api
+ */
+void idleGetStats(IdleStats *sp)
+{
+  chSysLock();
+  *sp = idle_stats;
+  chSysUnlock();
+}
+
+/**
+ * @brief   Shell command printing the idle residency.
+ *
+ * @param[in] chp       pointer to the shell stream
+ * @param[in] argc      number of arguments
+ * @param[in] argv      arguments
+ *
+ * @api
+ */
+void idleCmd(BaseSequentialStream *chp, int argc, char *argv[])
+{
+  IdleStats stats;
+  unsigned i;
+
+  (void)argv;
+
+  if (argc > 0)
+  {
+    shellUsage(chp, "idle");
+    return;
+  }
+
+  idleGetStats(&stats);
+  chprintf(chp, "%-6s %10s %10s" SHELL_NEWLINE_STR, "mode", "entries",
+           "time");
+  for (i = 0; i < IDLE_NUM_MODES; i++)
+    chprintf(chp, "%-6s %10lu %8lums" SHELL_NEWLINE_STR, idle_names[i],
+             (unsigned long)stats.mode[i].entries,
+             (unsigned long)(stats.mode[i].cycles / (STM32_HCLK / 1000U)));
+  chprintf(chp, "stop exit %luus, budget %luus, rtc %luHz" SHELL_NEWLINE_STR,
+           (unsigned long)stats.stop_exit_us,
+           (unsigned long)IDLE_LATENCY_BUDGET_US,
+           (unsigned long)stats.rtc_hz);
+}
+
+SHELL_COMMAND(idle, idleCmd);
+
+/** @} */
@@ -0,0 +1,124 @@
+/**
+ * @file    idle.h
+ * @brief   Tickless idle.
+ *
+ * @addtogroup IDLE
+ * @{
+ */
+
+#ifndef IDLE_H
+#define IDLE_H
+
+#include "ch.h"
+#include "hal.h"
+
+/*===========================================================================*/
+/* Module constants.                                                         */
+/*===========================================================================*/
+
+#define IDLE_WFI 0   /**< @brief Wait for interrupt, clocks running.    */
+#define IDLE_SLEEP 1 /**< @brief Wait for interrupt, flash clock gated. */
+#define IDLE_STOP 2  /**< @brief STOP mode, woken by the RTC alarm.     */
+#define IDLE_NUM_MODES 3
+
+/*===========================================================================*/
+/* Module pre-compile time settings.                                         */
+/*===========================================================================*/
+
+/**
+ * @brief   Longest interrupt latency that idling may add, in us.
+ * @details STOP is only entered while its worst exit time fits. Every
+ *          peripheral clock stops in STOP, zero keeps it off.
+ */
+#if !defined(IDLE_LATENCY_BUDGET_US) || defined(__DOXYGEN__)
+#define IDLE_LATENCY_BUDGET_US 0
+#endif
+
+/**
+ * @brief   STOP exit time assumed until one is measured, in us.
+ * @details HSE startup, PLL lock and RTC resynchronization.
+ */
+#if !defined(IDLE_STOP_EXIT_US) || defined(__DOXYGEN__)
+#define IDLE_STOP_EXIT_US 2000
+#endif
+
+/**
+ * @brief   Shortest idle time that gates the flash clock, in us.
+ */
+#if !defined(IDLE_SLEEP_MIN_US) || defined(__DOXYGEN__)
+#define IDLE_SLEEP_MIN_US 100
+#endif
+
+/**
+ * @brief   RTC alarm interrupt priority.
+ */
+#if !defined(IDLE_RTC_IRQ_PRIORITY) || defined(__DOXYGEN__)
+#define IDLE_RTC_IRQ_PRIORITY 15
+#endif
+
+/*===========================================================================*/
+/* Derived constants and error checks.                                       */
+/*===========================================================================*/
+
+#if HAL_USE_RTC == TRUE
+#error "the idle STOP mode drives the RTC, HAL_USE_RTC must be FALSE"
+#endif
+
+#if STM32_LSI_ENABLED == FALSE
+#error "the idle STOP mode requires the LSI clock"
+#endif
+
+#if CH_CFG_ST_TIMEDELTA == 0
+#error "the idle modes require the tickless mode"
+#endif
+
+/*===========================================================================*/
+/* Module data structures and types.                                         */
+/*===========================================================================*/
+
+/**
+ * @brief   Residency of an idle mode.
+ */
+typedef struct
+{
+  uint32_t entries; /**< @brief Times entered.                          */
+  uint64_t cycles;  /**< @brief Time spent, core cycles.                */
+} IdleResidency;
+
+/**
+ * @brief   Idle statistics.
+ */
+typedef struct
+{
+  IdleResidency mode[IDLE_NUM_MODES]; /**< @brief Per mode residency.   */
+  uint32_t stop_exit_us;  /**< @brief Worst STOP exit time.             */
+  uint32_t rtc_hz;        /**< @brief Calibrated RTC counter rate.      */
+} IdleStats;
+
+/*===========================================================================*/
+/* Module macros.                                                            */
+/*===========================================================================*/
+
+/*===========================================================================*/
+/* External declarations.                                                    */
+/*===========================================================================*/
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+  void idleInit(void);
+  void idleSleep(void);
+  void idleGetStats(IdleStats *sp);
+  void idleCmd(BaseSequentialStream *chp, int argc, char *argv[]);
+#ifdef __cplusplus
+}
+#endif
+
+/*===========================================================================*/
+/* Module inline functions.                                                  */
+/*===========================================================================*/
+
+#endif /* IDLE_H */
+
+/** @} */
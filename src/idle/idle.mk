@@ -0,0 +1,8 @@
+# Tickless idle files.
+IDLESRC = $(COREDIR)/src/idle/idle.c
+
+IDLEINC = $(COREDIR)/src/idle
+
+# Shared variables
+ALLCSRC += $(IDLESRC)
+ALLINC  += $(IDLEINC)
@@ -0,0 +1,280 @@
+/**
+ * @file    latency.c
+ * @brief   Latency histograms on top of the time measurement API.
+ * @details Every measurement is also counted in a log2 bucket, so the
+ *          percentiles can be estimated without keeping the samples. The
+ *          estimate interpolates within a bucket, it is exact to a factor
+ *          of two at worst and clamped to the best and worst measurements.
+ *          Objects register themselves at initialization and can be dumped
+ *          all at once from the shell.
+ *
+ * @addtogroup LATENCY
+ * @{
+ */
+
+#include "ch.h"
+#include "hal.h"
+#include "chprintf.h"
+#include "shell.h"
+#include "latency.h"
+
+#if (CH_CFG_USE_TM == TRUE) || defined(__DOXYGEN__)
+
+/*===========================================================================*/
+/* Module local definitions.                                                 */
+/*===========================================================================*/
+
+/*===========================================================================*/
+/* Module exported variables.                                                */
+/*===========================================================================*/
+
+/*===========================================================================*/
+/* Module local types.                                                       */
+/*===========================================================================*/
+
+/*===========================================================================*/
+/* Module local variables.                                                   */
+/*===========================================================================*/
+
+/**
+ * @brief   Registered measurements, most recent first.
+ */
+static LatencyHist *latency_list;
+
+/*===========================================================================*/
+/* Module local functions.                                                   */
+/*===========================================================================*/
+
+static void latency_count(LatencyHist *lhp, rtcnt_t cycles)
+{
+  unsigned b = cycles == 0U ? 0U : 32U - (unsigned)__builtin_clz(cycles);
+
+  if (b >= LATENCY_BUCKETS)
+    b = LATENCY_BUCKETS - 1U;
+  lhp->buckets[b]++;
+}
+
+/**
+ * @brief   Prints cycles as microseconds with one decimal.
+ */
+static void latency_print_us(BaseSequentialStream *chp, rtcnt_t cycles)
+{
+  uint32_t t = (uint32_t)(((uint64_t)cycles * 10U + STM32_HCLK / 2000000U) /
+                          (STM32_HCLK / 1000000U));
+
+  chprintf(chp, " %7lu.%lu", (unsigned long)(t / 10U),
+           (unsigned long)(t % 10U));
+}
+
+/*===========================================================================*/
+/* Module exported functions.                                                */
+/*===========================================================================*/
+
+/**
+ * @brief   Initializes and registers a measurement.
+ *
+ * @param[out] lhp      pointer to the @p LatencyHist object
+ * @param[in] name      name in the dump
+ *
+ * @init
+ */
+void latencyObjectInit(LatencyHist *lhp, const char *name)
+{
+  unsigned i;
+
+  chTMObjectInit(&lhp->tm);
+  for (i = 0; i < LATENCY_BUCKETS; i++)
+    lhp->buckets[i] = 0;
+  lhp->name = name;
+
+  chSysLock();
+  lhp->next = latency_list;
+  latency_list = lhp;
+  chSysUnlock();
+}
+
+/**
+ * @brief   Starts a measurement.
+ *
+ * @param[in] lhp       pointer to the @p LatencyHist object
+ *
+ * @xclass
+ */
+void latencyStartX(LatencyHist *lhp)
+{
+  chTMStartMeasurementX(&lhp->tm);
+}
+
+/**
+ * @brief   Stops a measurement.
+ *
+ * @param[in] lhp       pointer to the @p LatencyHist object
+ *
+ * @xclass
+ */
+void latencyStopX(LatencyHist *lhp)
+{
+  syssts_t sts = chSysGetStatusAndLockX();
+
+  chTMStopMeasurementX(&lhp->tm);
+  latency_count(lhp, lhp->tm.last);
+  chSysRestoreStatusX(sts);
+}
+
+/**
+ * @brief   Adds a latency measured by other means.
+ * @details Meant for the delay from an interrupt timestamp to the thread
+ *          serving it, the timestamps tick at the same rate as the
+ *          realtime counter.
+ * @note    Overwrites the start of a measurement in progress.
+ *
+ * @param[in] lhp       pointer to the @p LatencyHist object
+ * @param[in] cycles    latency, realtime counter cycles
+ *
+ * @xclass
+ */
+void latencyAddX(LatencyHist *lhp, rtcnt_t cycles)
+{
+  time_measurement_t *tmp = &lhp->tm;
+  syssts_t sts = chSysGetStatusAndLockX();
+
+  tmp->n++;
+  tmp->last = cycles;
+  tmp->cumulative += (rttime_t)cycles;
+  if (cycles > tmp->worst)
+    tmp->worst = cycles;
+  if (cycles < tmp->best)
+    tmp->best = cycles;
+  latency_count(lhp, cycles);
+  chSysRestoreStatusX(sts);
+}
+
+/**
+ * @brief   Takes a consistent copy of a measurement.
+ *
+ * @param[in] lhp       pointer to the @p LatencyHist object
+ * @param[out] sp       copy
+ * @param[in] reset     clears the measurement after the copy, a
+ *                      measurement in progress is kept
+ *
+ * @api
+ */
+void latencySnapshot(LatencyHist *lhp, LatencySnapshot *sp, bool reset)
+{
+  time_measurement_t *tmp = &lhp->tm;
+  unsigned i;
+
+  chSysLock();
+  sp->best = tmp->best;
+  sp->worst = tmp->worst;
+  sp->n = tmp->n;
+  sp->cumulative = tmp->cumulative;
+  for (i = 0; i < LATENCY_BUCKETS; i++)
+  {
+    sp->buckets[i] = lhp->buckets[i];
+    if (reset)
+      lhp->buckets[i] = 0;
+  }
+  if (reset)
+  {
+    /* The last field holds the start time while measuring.*/
+    rtcnt_t last = tmp->last;
+
+    chTMObjectInit(tmp);
+    tmp->last = last;
+  }
+  chSysUnlock();
+}
+
+/**
+ * @brief   Estimates a percentile.
+ *
+ * @param[in] sp        pointer to a snapshot
+ * @param[in] p         percentile, in 1/10000, see @p LATENCY_P50 and the
+ *                      other constants
+ * @return              The latency, cycles, zero without measurements.
+ *
+ * @api
+ */
+rtcnt_t latencyPercentile(const LatencySnapshot *sp, uint32_t p)
+{
+  uint64_t total = 0, rank, below = 0;
+  unsigned b;
+
+  chDbgCheck(p <= 10000U);
+
+  for (b = 0; b < LATENCY_BUCKETS; b++)
+    total += sp->buckets[b];
+  if (total == 0)
+    return 0;
+
+  /* Rank of the sample, from 1 to total.*/
+  rank = (total * p + 9999U) / 10000U;
+  if (rank == 0)
+    rank = 1;
+
+  for (b = 0; below + sp->buckets[b] < rank; b++)
+    below += sp->buckets[b];
+
+  {
+    uint64_t lo = b == 0 ? 0 : 1ULL << (b - 1U), hi = 1ULL << b;
+    uint64_t v = lo + (hi - lo) * (rank - below) / sp->buckets[b];
+
+    if (b == LATENCY_BUCKETS - 1U || v > sp->worst)
+      v = sp->worst;
+    if (v < sp->best)
+      v = sp->best;
+    return (rtcnt_t)v;
+  }
+}
+
+/**
+ * @brief   First registered measurement.
+ * @details The others follow through the @p next field.
+ *
+ * @return              The most recently registered measurement.
+ *
+ * @api
+ */
+LatencyHist *latencyFirst(void)
+{
+  return latency_list;
+}
+
+/**
+ * @brief   Dumps every registered measurement.
+ *
+ * @param[in] chp       output stream
+ * @param[in] reset     clears the measurements after reading them
+ *
+ * @api
+ */
+void latencyPrint(BaseSequentialStream *chp, bool reset)
+{
+  LatencyHist *lhp;
+  LatencySnapshot s;
+
+  chprintf(chp, "%-12s %10s %9s %9s %9s %9s %9s %9s" SHELL_NEWLINE_STR,
+           "name", "n", "best", "mean", "p50", "p99", "p99.9", "worst");
+  for (lhp = latencyFirst(); lhp != NULL; lhp = lhp->next)
+  {
+    latencySnapshot(lhp, &s, reset);
+    chprintf(chp, "%-12s %10lu", lhp->name, (unsigned long)s.n);
+    if (s.n == 0)
+    {
+      chprintf(chp, SHELL_NEWLINE_STR);
+      continue;
+    }
+    latency_print_us(chp, s.best);
+    latency_print_us(chp, (rtcnt_t)(s.cumulative / s.n));
+    latency_print_us(chp, latencyPercentile(&s, LATENCY_P50));
+    latency_print_us(chp, latencyPercentile(&s, LATENCY_P99));
+    latency_print_us(chp, latencyPercentile(&s, LATENCY_P999));
+    latency_print_us(chp, s.worst);
+    chprintf(chp, SHELL_NEWLINE_STR);
+  }
+}
+
+#endif /* CH_CFG_USE_TM == TRUE */
+
+/** @} */
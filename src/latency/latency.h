@@ -0,0 +1,113 @@
+/**
+ * @file    latency.h
+ * @brief   Latency histograms on top of the time measurement API.
+ *
+ * @addtogroup LATENCY
+ * @{
+ */
+
+#ifndef LATENCY_H
+#define LATENCY_H
+
+#include "ch.h"
+#include "hal.h"
+
+#if (CH_CFG_USE_TM == TRUE) || defined(__DOXYGEN__)
+
+/*===========================================================================*/
+/* Module constants.                                                         */
+/*===========================================================================*/
+
+/**
+ * @name    Percentiles
+ * @{
+ */
+#define LATENCY_P50 5000U  /**< @brief Median, in 1/10000.             */
+#define LATENCY_P99 9900U  /**< @brief 99th percentile.                */
+#define LATENCY_P999 9990U /**< @brief 99.9th percentile.              */
+/** @} */
+
+/*===========================================================================*/
+/* Module pre-compile time settings.                                         */
+/*===========================================================================*/
+
+/**
+ * @brief   Number of log2 buckets.
+ * @details Bucket @p i counts the measurements from 2^(i-1) to 2^i - 1
+ *          cycles, the last one also counts everything longer.
+ */
+#if !defined(LATENCY_BUCKETS) || defined(__DOXYGEN__)
+#define LATENCY_BUCKETS 24
+#endif
+
+/*===========================================================================*/
+/* Derived constants and error checks.                                       */
+/*===========================================================================*/
+
+#if (LATENCY_BUCKETS < 2) || (LATENCY_BUCKETS > 32)
+#error "LATENCY_BUCKETS must be between 2 and 32"
+#endif
+
+/*===========================================================================*/
+/* Module data structures and types.                                         */
+/*===========================================================================*/
+
+/**
+ * @brief   Latency measurement object.
+ * @details The time measurement comes first, @p &lhp->tm can be passed to
+ *          the @p chTM API, measurements taken that way only miss the
+ *          histogram.
+ */
+typedef struct latency_hist
+{
+  time_measurement_t tm;              /**< @brief Time measurement.      */
+  uint32_t buckets[LATENCY_BUCKETS];  /**< @brief Histogram.             */
+  const char *name;                   /**< @brief Name in the dump.      */
+  struct latency_hist *next;          /**< @brief Next registered one.   */
+} LatencyHist;
+
+/**
+ * @brief   Consistent copy of a measurement.
+ */
+typedef struct
+{
+  rtcnt_t best;                       /**< @brief Best measurement.      */
+  rtcnt_t worst;                      /**< @brief Worst measurement.     */
+  ucnt_t n;                           /**< @brief Number of measurements. */
+  rttime_t cumulative;                /**< @brief Sum of the measurements. */
+  uint32_t buckets[LATENCY_BUCKETS];  /**< @brief Histogram.             */
+} LatencySnapshot;
+
+/*===========================================================================*/
+/* Module macros.                                                            */
+/*===========================================================================*/
+
+/*===========================================================================*/
+/* External declarations.                                                    */
+/*===========================================================================*/
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+  void latencyObjectInit(LatencyHist *lhp, const char *name);
+  void latencyStartX(LatencyHist *lhp);
+  void latencyStopX(LatencyHist *lhp);
+  void latencyAddX(LatencyHist *lhp, rtcnt_t cycles);
+  void latencySnapshot(LatencyHist *lhp, LatencySnapshot *sp, bool reset);
+  rtcnt_t latencyPercentile(const LatencySnapshot *sp, uint32_t p);
+  LatencyHist *latencyFirst(void);
+  void latencyPrint(BaseSequentialStream *chp, bool reset);
+#ifdef __cplusplus
+}
+#endif
+
+/*===========================================================================*/
+/* Module inline functions.                                                  */
+/*===========================================================================*/
+
+#endif /* CH_CFG_USE_TM == TRUE */
+
+#endif /* LATENCY_H */
+
+/** @} */
@@ -0,0 +1,8 @@
+# Latency histogram files.
+LATENCYSRC = $(COREDIR)/src/latency/latency.c
+
+LATENCYINC = $(COREDIR)/src/latency
+
+# Shared variables
+ALLCSRC += $(LATENCYSRC)
+ALLINC  += $(LATENCYINC)
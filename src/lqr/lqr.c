@@ -0,0 +1,181 @@
+/**
+ * @file    lqr.c
+ * @brief   Q31 state feedback controller.
+ * @details Computes u = -K (x - xref) with a gain matrix interpolated from
+ *          a schedule. Each input is the dot product of a gain row and the
+ *          state error, there is one fully unrolled kernel per number of
+ *          states and the dispatch happens once per update, the inner loop
+ *          of a generic matrix product is gone. Products accumulate in 64
+ *          bits like @p arm_mat_mult_q31(), the state errors are expected
+ *          to leave the headroom for the accumulation.
+ *
+ * @addtogroup LQR
+ * @{
+ */
+
+#include "ch.h"
+#include "lqr.h"
+
+/*===========================================================================*/
+/* Module local definitions.                                                 */
+/*===========================================================================*/
+
+/*===========================================================================*/
+/* Module exported variables.                                                */
+/*===========================================================================*/
+
+/*===========================================================================*/
+/* Module local types.                                                       */
+/*===========================================================================*/
+
+/*===========================================================================*/
+/* Module local variables.                                                   */
+/*===========================================================================*/
+
+/*===========================================================================*/
+/* Module local functions.                                                   */
+/*===========================================================================*/
+
+static inline q63_t lqr_dot2(const q31_t *k, const q31_t *e)
+{
+  return (q63_t)k[0] * e[0] + (q63_t)k[1] * e[1];
+}
+
+static inline q63_t lqr_dot3(const q31_t *k, const q31_t *e)
+{
+  return (q63_t)k[0] * e[0] + (q63_t)k[1] * e[1] + (q63_t)k[2] * e[2];
+}
+
+static inline q63_t lqr_dot4(const q31_t *k, const q31_t *e)
+{
+  return (q63_t)k[0] * e[0] + (q63_t)k[1] * e[1] + (q63_t)k[2] * e[2] +
+         (q63_t)k[3] * e[3];
+}
+
+static inline q63_t lqr_dot5(const q31_t *k, const q31_t *e)
+{
+  return (q63_t)k[0] * e[0] + (q63_t)k[1] * e[1] + (q63_t)k[2] * e[2] +
+         (q63_t)k[3] * e[3] + (q63_t)k[4] * e[4];
+}
+
+static inline q63_t lqr_dot6(const q31_t *k, const q31_t *e)
+{
+  return (q63_t)k[0] * e[0] + (q63_t)k[1] * e[1] + (q63_t)k[2] * e[2] +
+         (q63_t)k[3] * e[3] + (q63_t)k[4] * e[4] + (q63_t)k[5] * e[5];
+}
+
+/*===========================================================================*/
+/* Module exported functions.                                                */
+/*===========================================================================*/
+
+/**
+ * @brief   Initializes a controller with the first schedule point.
+ *
+ * @param[out] lqrp     pointer to the @p Lqr object
+ * @param[in] config    pointer to the controller configuration
+ *
+ * @api
+ */
+void lqrInit(Lqr *lqrp, const LqrConfig *config)
+{
+  unsigned i;
+
+  chDbgCheck((config->n >= 2) && (config->n <= LQR_MAX_STATES) &&
+             (config->m >= 1) && (config->m <= LQR_MAX_INPUTS) &&
+             (config->shift < 31) && (config->npoints > 0));
+
+  lqrp->config = config;
+  for (i = 0; i < config->n * config->m; i++)
+    lqrp->k[i] = config->schedule[0].k[i];
+}
+
+/**
+ * @brief   Interpolates the gains at a value of the scheduling variable.
+ * @details Linear interpolation between the two nearest points, the
+ *          gains of the end points are used outside of the schedule.
+ * @note    Meant to be called at the scheduling rate from the thread
+ *          running @p lqrUpdate().
+ *
+ * @param[in] lqrp      pointer to the @p Lqr object
+ * @param[in] param     scheduling variable
+ *
+ * @api
+ */
+void lqrSchedule(Lqr *lqrp, q31_t param)
+{
+  const LqrConfig *cfg = lqrp->config;
+  const LqrGain *a, *b;
+  unsigned i, size = cfg->n * cfg->m;
+  q31_t t;
+
+  for (i = 1; i < cfg->npoints && cfg->schedule[i].param <= param; i++)
+    ;
+  a = &cfg->schedule[i - 1];
+  if (i == cfg->npoints || param <= a->param)
+  {
+    for (i = 0; i < size; i++)
+      lqrp->k[i] = a->k[i];
+    return;
+  }
+
+  b = &cfg->schedule[i];
+  t = (q31_t)((((q63_t)param - a->param) << 31) /
+              ((q63_t)b->param - a->param));
+  for (i = 0; i < size; i++)
+    lqrp->k[i] = (q31_t)(a->k[i] +
+                         ((((q63_t)b->k[i] - a->k[i]) * t) >> 31));
+}
+
+/**
+ * @brief   Controller step.
+ *
+ * @param[in] lqrp      pointer to the @p Lqr object
+ * @param[in] x         state vector
+ * @param[in] xref      reference state vector, @p NULL for the origin
+ * @param[out] u        saturated input vector
+ *
+ * @api
+ */
+void lqrUpdate(Lqr *lqrp, const q31_t *x, const q31_t *xref, q31_t *u)
+{
+  const LqrConfig *cfg = lqrp->config;
+  const q31_t *k = lqrp->k;
+  q31_t e[LQR_MAX_STATES];
+  q63_t acc;
+  unsigned i;
+
+  for (i = 0; i < cfg->n; i++)
+    e[i] = xref == NULL ? x[i] : clip_q63_to_q31((q63_t)x[i] - xref[i]);
+
+  for (i = 0; i < cfg->m; i++, k += cfg->n)
+  {
+    switch (cfg->n)
+    {
+    case 2:
+      acc = lqr_dot2(k, e);
+      break;
+    case 3:
+      acc = lqr_dot3(k, e);
+      break;
+    case 4:
+      acc = lqr_dot4(k, e);
+      break;
+    case 5:
+      acc = lqr_dot5(k, e);
+      break;
+    default:
+      acc = lqr_dot6(k, e);
+      break;
+    }
+
+    acc = -(acc >> (31 - cfg->shift));
+    if (acc < cfg->umin)
+      u[i] = cfg->umin;
+    else if (acc > cfg->umax)
+      u[i] = cfg->umax;
+    else
+      u[i] = (q31_t)acc;
+  }
+}
+
+/** @} */
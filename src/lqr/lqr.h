@@ -0,0 +1,104 @@
+/**
+ * @file    lqr.h
+ * @brief   Q31 state feedback controller.
+ *
+ * @addtogroup LQR
+ * @{
+ */
+
+#ifndef LQR_H
+#define LQR_H
+
+#include "ch.h"
+#include "arm_math.h"
+
+/*===========================================================================*/
+/* Module constants.                                                         */
+/*===========================================================================*/
+
+/**
+ * @brief   Largest number of states.
+ */
+#define LQR_MAX_STATES 6
+
+/*===========================================================================*/
+/* Module pre-compile time settings.                                         */
+/*===========================================================================*/
+
+/**
+ * @brief   Largest number of inputs.
+ */
+#if !defined(LQR_MAX_INPUTS) || defined(__DOXYGEN__)
+#define LQR_MAX_INPUTS 2
+#endif
+
+/*===========================================================================*/
+/* Derived constants and error checks.                                       */
+/*===========================================================================*/
+
+/*===========================================================================*/
+/* Module data structures and types.                                         */
+/*===========================================================================*/
+
+/**
+ * @brief   Gain schedule point.
+ */
+typedef struct
+{
+  q31_t param;    /**< @brief Scheduling variable value.                 */
+  const q31_t *k; /**< @brief Gain matrix at this point, inputs x states,
+                              row-major.                                */
+} LqrGain;
+
+/**
+ * @brief   Controller configuration.
+ */
+typedef struct
+{
+  unsigned n;               /**< @brief Number of states, 2 to
+                                        @p LQR_MAX_STATES.              */
+  unsigned m;               /**< @brief Number of inputs, 1 to
+                                        @p LQR_MAX_INPUTS.              */
+  unsigned shift;           /**< @brief Gains are Q(31 - shift).        */
+  const LqrGain *schedule;  /**< @brief Gain schedule, by increasing
+                                        scheduling variable.            */
+  unsigned npoints;         /**< @brief Number of schedule points.      */
+  q31_t umin;               /**< @brief Lower input limit.              */
+  q31_t umax;               /**< @brief Upper input limit.              */
+} LqrConfig;
+
+/**
+ * @brief   Controller object.
+ */
+typedef struct
+{
+  const LqrConfig *config;                    /**< @brief Configuration. */
+  q31_t k[LQR_MAX_INPUTS * LQR_MAX_STATES];   /**< @brief Active gains.  */
+} Lqr;
+
+/*===========================================================================*/
+/* Module macros.                                                            */
+/*===========================================================================*/
+
+/*===========================================================================*/
+/* External declarations.                                                    */
+/*===========================================================================*/
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+  void lqrInit(Lqr *lqrp, const LqrConfig *config);
+  void lqrSchedule(Lqr *lqrp, q31_t param);
+  void lqrUpdate(Lqr *lqrp, const q31_t *x, const q31_t *xref, q31_t *u);
+#ifdef __cplusplus
+}
+#endif
+
+/*===========================================================================*/
+/* Module inline functions.                                                  */
+/*===========================================================================*/
+
+#endif /* LQR_H */
+
+/** @} */
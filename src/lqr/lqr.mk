@@ -0,0 +1,8 @@
+# State feedback controller files.
+LQRSRC = $(COREDIR)/src/lqr/lqr.c
+
+LQRINC = $(COREDIR)/src/lqr
+
+# Shared variables
+ALLCSRC += $(LQRSRC)
+ALLINC  += $(LQRINC)
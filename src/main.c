@@ -9,9 +9,33 @@
  */
 #include "ch.h"
 #include "hal.h"
+#include "adc_stream.h"
+#include "boot.h"
+#include "idle.h"
+#include "motor.h"
+#include "shell.h"
+#include "timestamp.h"
+#include "warm.h"
+#include "watchdog.h"
+#include "objreg.h"
+#include "work.h"
 
 static volatile uint16_t val = 0;
 
+/*
+ * CAN1 at 1 Mbps from the 36 MHz APB1 clock, 9 quanta per bit sampled at
+ * 78%, for the ESC feedback.
+ */
+static const CANConfig can_config = {
+    CAN_MCR_ABOM | CAN_MCR_AWUM | CAN_MCR_TXFP,
+    CAN_BTR_SJW(0) | CAN_BTR_TS2(1) | CAN_BTR_TS1(5) | CAN_BTR_BRP(3)};
+
+/*
+ * Debug shell on USART1, the commands are registered by the modules.
+ */
+static THD_WORKING_AREA(shell_wa, 1024);
+static const ShellConfig shell_cfg = {(BaseSequentialStream *)&SD1, NULL};
+
 void turnOffLED(void)
 {
     palSetLine(LINE_LED);
@@ -24,8 +48,39 @@ void turnOnLED(void)
     return;
 }
 
+static void startShell(void)
+{
+    sdStart(&SD1, NULL);
+    shellInit();
+    chThdCreateStatic(shell_wa, sizeof(shell_wa), NORMALPRIO - 1, shellThread,
+                      (void *)&shell_cfg);
+}
+
+/*
+ * Stages off the critical path, run once the control threads are up.
+ */
+static const BootStage deferred_stages[] = {
+    /* Continuous sampling of battery, chassis current and supercap voltage.*/
+    {"adc", adcStreamInit},
+    /* RTC calibration for the STOP idle mode.*/
+    {"idle", idleInit},
+    /* Debug shell, last so that every command is ready.*/
+    {"shell", startShell},
+};
+
 int main(void)
 {
+    /*
+     * Stage timestamps from the top of main().
+     */
+    bootInit();
+
+    /*
+     * Reset cause and state saved before a watchdog or software reset,
+     * checked before anything touches the RAM.
+     */
+    warmInit();
+
     /*
      * System initializations.
      * - HAL initialization, this also initializes the configured device drivers
@@ -34,7 +89,52 @@ int main(void)
      *   RTOS is active.
      */
     halInit();
+    bootMark("hal");
     chSysInit();
+    bootMark("kernel");
+
+    /*
+     * Common time base for the interrupt timestamps.
+     */
+    tsInit();
+
+    /*
+     * Shared worker threads for the work deferred by the interrupt handlers.
+     */
+    workStart();
+
+    /*
+     * Name lookup of the objects registered by the modules.
+     */
+    objregInit();
+    bootMark("services");
+
+    /*
+     * Saved state back into the modules, then kept up to date.
+     */
+    warmRestore();
+    warmStart();
+    bootMark("warm");
+
+    /*
+     * Supervision of the threads registered by the modules.
+     */
+    watchdogStart();
+
+    /*
+     * ESC feedback on CAN1, supervised by the watchdog, the multi-turn
+     * positions continue from the restored state.
+     */
+    canStart(&CAND1, &can_config);
+    motorStart(&CAND1);
+    bootMark("can");
+
+    /*
+     * Critical path above, the rest of the initialization runs at a
+     * background priority.
+     */
+    bootRunDeferred(deferred_stages,
+                    sizeof(deferred_stages) / sizeof(deferred_stages[0]));
 
     /***************************************************************
      ***************************************************************/
@@ -0,0 +1,310 @@
+/**
+ * @file    motor.c
+ * @brief   RoboMaster C610/C620 ESC feedback decoder.
+ * @details A thread drains the CAN receive FIFO in batches and decodes the
+ *          ESC feedback frames: the single-turn encoder angle is unwrapped
+ *          to a multi-turn position and an alpha-beta filter estimates the
+ *          rotor speed from it. The state of each motor is published in a
+ *          table protected by a sequence counter, readers copy a consistent
+ *          snapshot without blocking the decoder.
+ *
+ * @addtogroup MOTOR
+ * @{
+ */
+
+#include "ch.h"
+#include "hal.h"
+#include "warm.h"
+#include "watchdog.h"
+#include "motor.h"
+
+/*===========================================================================*/
+/* Module local definitions.                                                 */
+/*===========================================================================*/
+
+/**
+ * @brief   Longest filter step, longer gaps restart the filter.
+ */
+#define MOTOR_MAX_DT US2TS(MOTOR_STALE_MS * 1000U)
+
+/**
+ * @brief   Longest age of the saved state at a warm reset, in ms.
+ * @details One save period, a stalled decoder missing its watchdog
+ *          deadline, and the IWDG timeout on the slowest LSI.
+ */
+#define MOTOR_RESUME_AGE_MS                                               \
+  (WARM_SAVE_PERIOD + MOTOR_WATCHDOG_MS + WATCHDOG_TIMEOUT * 5 / 3)
+
+/*===========================================================================*/
+/* Module exported variables.                                                */
+/*===========================================================================*/
+
+/*===========================================================================*/
+/* Module local types.                                                       */
+/*===========================================================================*/
+
+/**
+ * @brief   Decoder private state of a motor.
+ */
+typedef struct
+{
+  int64_t x;      /**< @brief Filtered position, counts in Q16.         */
+  int64_t v;      /**< @brief Filtered speed, counts/s in Q16.          */
+  int64_t pos;    /**< @brief Unwrapped measured position, counts.      */
+  tstamp_t last;  /**< @brief Time of the last frame.                   */
+  bool valid;     /**< @brief Filter initialized.                       */
+  bool resume;    /**< @brief Restored after a warm restart, the first
+                              frame may keep the turn count.            */
+} MotorFilter;
+
+/**
+ * @brief   Published state of a motor.
+ */
+typedef struct
+{
+  volatile uint32_t seq; /**< @brief Odd while being written.           */
+  MotorState state;      /**< @brief Latest state.                      */
+} MotorSlot;
+
+/*===========================================================================*/
+/* Module local variables.                                                   */
+/*===========================================================================*/
+
+static MotorFilter filters[MOTOR_NUM];
+static MotorSlot slots[MOTOR_NUM];
+static CANRxFrame frames[MOTOR_BATCH_SIZE];
+static THD_WORKING_AREA(motor_wa, MOTOR_THREAD_WA_SIZE);
+static WatchdogClient motor_wdg;
+
+WARM_REGISTER(motor, filters);
+
+/*===========================================================================*/
+/* Module local functions.                                                   */
+/*===========================================================================*/
+
+static void motor_publish_begin(MotorSlot *sp)
+{
+  sp->seq++;
+  __DMB();
+}
+
+static void motor_publish_end(MotorSlot *sp)
+{
+  __DMB();
+  sp->seq++;
+}
+
+/**
+ * @brief   Checks that the rotor turned less than half a revolution since
+ *          the saved state.
+ * @details Both the saved speed and the speed reported by the first frame
+ *          are held over the age of the saved state plus the boot time.
+ *
+ * @param[in] fp        pointer to the restored filter
+ * @param[in] rpm       speed reported by the first frame
+ * @param[in] stamp     time of the first frame, since boot
+ * @return              The turn count can be kept.
+ */
+static bool motor_resume_ok(const MotorFilter *fp, int16_t rpm,
+                            tstamp_t stamp)
+{
+  uint64_t age = (uint64_t)MOTOR_RESUME_AGE_MS * 1000U + TS2US(stamp);
+  uint64_t v = (uint64_t)(fp->v < 0 ? -fp->v : fp->v) >> 16;
+  uint64_t vr = (uint64_t)(rpm < 0 ? -rpm : rpm) * MOTOR_COUNTS_PER_REV / 60;
+
+  if (vr > v)
+    v = vr;
+  return v * age < (uint64_t)(MOTOR_COUNTS_PER_REV / 2) * 1000000U;
+}
+
+/**
+ * @brief   Decodes a feedback frame.
+ */
+static void motor_decode(const CANRxFrame *crfp, tstamp_t stamp)
+{
+  unsigned id = crfp->SID - MOTOR_FEEDBACK_SID;
+  MotorFilter *fp;
+  MotorSlot *sp;
+  uint16_t angle;
+  int16_t rpm;
+  int64_t r;
+  int32_t dt;
+
+  if (crfp->IDE || crfp->RTR || crfp->DLC != 8 || id >= MOTOR_NUM)
+    return;
+
+  fp = &filters[id];
+  sp = &slots[id];
+  angle = (uint16_t)((crfp->data8[0] << 8) | crfp->data8[1]) &
+          (MOTOR_COUNTS_PER_REV - 1);
+  rpm = (int16_t)((crfp->data8[2] << 8) | crfp->data8[3]);
+
+  if (!fp->valid || (stamp - fp->last) > MOTOR_MAX_DT)
+  {
+    /* First frame or a gap, restart from the measurement and the speed
+       reported by the ESC. After a warm restart the turn count is kept
+       only if the rotor was too slow to turn half a revolution since the
+       saved position, otherwise the position starts over like a cold
+       start.*/
+    if (fp->resume && motor_resume_ok(fp, rpm, stamp))
+      fp->pos += (int32_t)((uint32_t)(angle - (uint16_t)fp->pos) << 19) >> 19;
+    else
+      fp->pos = angle;
+    fp->resume = false;
+    fp->x = fp->pos << 16;
+    fp->v = ((int64_t)rpm * MOTOR_COUNTS_PER_REV << 16) / 60;
+    fp->valid = true;
+  }
+  else
+  {
+    /* Shortest path between the two angles, the rotor turns less than
+       half a revolution between two frames.*/
+    fp->pos += (int32_t)((uint32_t)(angle - sp->state.angle) << 19) >> 19;
+
+    dt = TS2Q31(stamp - fp->last);
+    if (dt > 0)
+    {
+      fp->x += (fp->v * dt) >> 31;
+      r = (fp->pos << 16) - fp->x;
+      fp->x += (r * MOTOR_FILTER_ALPHA) >> 16;
+      fp->v += (((r * MOTOR_FILTER_BETA) >> 16) << 31) / dt;
+    }
+  }
+  fp->last = stamp;
+
+  motor_publish_begin(sp);
+  sp->state.stamp = stamp;
+  sp->state.position = fp->pos;
+  sp->state.velocity = (int32_t)(fp->v >> 16);
+  sp->state.rpm = rpm;
+  sp->state.current = (int16_t)((crfp->data8[4] << 8) | crfp->data8[5]);
+  sp->state.angle = angle;
+  sp->state.temperature = crfp->data8[6];
+  sp->state.online = true;
+  motor_publish_end(sp);
+}
+
+/**
+ * @brief   Marks as offline the motors without recent feedback.
+ */
+static void motor_check_stale(tstamp_t now)
+{
+  unsigned id;
+
+  for (id = 0; id < MOTOR_NUM; id++)
+  {
+    MotorSlot *sp = &slots[id];
+
+    if (sp->state.online && (now - sp->state.stamp) > MOTOR_MAX_DT)
+    {
+      motor_publish_begin(sp);
+      sp->state.online = false;
+      motor_publish_end(sp);
+      filters[id].valid = false;
+    }
+  }
+}
+
+static THD_FUNCTION(motor_thread, arg)
+{
+  CANDriver *canp = arg;
+  tstamp_t stamp;
+  unsigned i, n;
+
+  chRegSetThreadName("motor");
+
+  while (true)
+  {
+    watchdogCheckIn(&motor_wdg);
+    n = 0;
+    if (canReceiveTimeout(canp, CAN_ANY_MAILBOX, &frames[0],
+                          TIME_MS2I(MOTOR_STALE_MS)) == MSG_OK)
+    {
+      /* The rest of the burst without blocking, all the frames share the
+         stamp of the receive interrupt that woke the thread.*/
+      n = 1;
+      chSysLock();
+      while (n < MOTOR_BATCH_SIZE &&
+             !canTryReceiveI(canp, CAN_ANY_MAILBOX, &frames[n]))
+        n++;
+      chSysUnlock();
+    }
+
+#if CAN_ENFORCE_USE_CALLBACKS == TRUE
+    stamp = canp == &CAND1 ? tsGetStampX(TS_SOURCE_CAN1) : tsNowX();
+#else
+    stamp = tsNowX();
+#endif
+    for (i = 0; i < n; i++)
+      motor_decode(&frames[i], stamp);
+
+    motor_check_stale(tsNowX());
+  }
+}
+
+/*===========================================================================*/
+/* Module exported functions.                                                */
+/*===========================================================================*/
+
+/**
+ * @brief   Starts the feedback decoder.
+ * @note    The CAN driver is started by the caller and must not be read by
+ *          any other thread, on @p CAND1 the receive callback is replaced
+ *          by the timestamp one.
+ * @note    Called after @p warmRestore(), the multi-turn positions then
+ *          continue from the saved ones, unless a rotor was fast enough
+ *          to turn half a revolution since the state was saved.
+ *
+ * @param[in] canp      pointer to a started @p CANDriver object
+ *
+ * @api
+ */
+void motorStart(CANDriver *canp)
+{
+  unsigned id;
+
+  for (id = 0; id < MOTOR_NUM; id++)
+  {
+    filters[id].resume = filters[id].valid && warmIsRestored();
+    filters[id].valid = false;
+  }
+
+#if CAN_ENFORCE_USE_CALLBACKS == TRUE
+  if (canp == &CAND1)
+    canp->rxfull_cb = tsCANRxFullCb;
+#endif
+
+  watchdogObjectInit(&motor_wdg, "motor", MOTOR_WATCHDOG_MS);
+  chThdCreateStatic(motor_wa, sizeof(motor_wa), MOTOR_THREAD_PRIORITY,
+                    motor_thread, canp);
+}
+
+/**
+ * @brief   Latest state of a motor.
+ *
+ * @param[in] id        ESC identifier, from 1 to @p MOTOR_NUM
+ * @param[out] msp      pointer to the snapshot
+ * @return              The motor is online.
+ *
+ * @api
+ */
+bool motorGet(unsigned id, MotorState *msp)
+{
+  const MotorSlot *sp;
+  uint32_t seq;
+
+  chDbgCheck(id >= 1 && id <= MOTOR_NUM);
+
+  sp = &slots[id - 1];
+  do
+  {
+    seq = sp->seq;
+    __DMB();
+    *msp = sp->state;
+    __DMB();
+  } while ((seq & 1U) != 0 || seq != sp->seq);
+
+  return msp->online;
+}
+
+/** @} */
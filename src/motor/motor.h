@@ -0,0 +1,141 @@
+/**
+ * @file    motor.h
+ * @brief   RoboMaster C610/C620 ESC feedback decoder.
+ *
+ * @addtogroup MOTOR
+ * @{
+ */
+
+#ifndef MOTOR_H
+#define MOTOR_H
+
+#include "ch.h"
+#include "hal.h"
+#include "timestamp.h"
+
+/*===========================================================================*/
+/* Module constants.                                                         */
+/*===========================================================================*/
+
+/**
+ * @brief   Number of ESC identifiers on a bus.
+ */
+#define MOTOR_NUM 8
+
+/**
+ * @brief   Feedback identifier of the ESC with identifier 1.
+ */
+#define MOTOR_FEEDBACK_SID 0x201U
+
+/**
+ * @brief   Encoder counts per rotor revolution.
+ */
+#define MOTOR_COUNTS_PER_REV 8192
+
+/*===========================================================================*/
+/* Module pre-compile time settings.                                         */
+/*===========================================================================*/
+
+/**
+ * @brief   Largest number of frames decoded per wakeup.
+ */
+#if !defined(MOTOR_BATCH_SIZE) || defined(__DOXYGEN__)
+#define MOTOR_BATCH_SIZE 8
+#endif
+
+/**
+ * @brief   Time without feedback after which a motor is offline, in ms.
+ */
+#if !defined(MOTOR_STALE_MS) || defined(__DOXYGEN__)
+#define MOTOR_STALE_MS 20
+#endif
+
+/**
+ * @brief   Position gain of the alpha-beta filter, Q16.
+ */
+#if !defined(MOTOR_FILTER_ALPHA) || defined(__DOXYGEN__)
+#define MOTOR_FILTER_ALPHA 32768
+#endif
+
+/**
+ * @brief   Velocity gain of the alpha-beta filter, Q16.
+ */
+#if !defined(MOTOR_FILTER_BETA) || defined(__DOXYGEN__)
+#define MOTOR_FILTER_BETA 6554
+#endif
+
+/**
+ * @brief   Decoder thread priority.
+ */
+#if !defined(MOTOR_THREAD_PRIORITY) || defined(__DOXYGEN__)
+#define MOTOR_THREAD_PRIORITY (NORMALPRIO + 2)
+#endif
+
+/**
+ * @brief   Decoder thread working area size.
+ */
+#if !defined(MOTOR_THREAD_WA_SIZE) || defined(__DOXYGEN__)
+#define MOTOR_THREAD_WA_SIZE 256
+#endif
+
+/**
+ * @brief   Decoder thread watchdog deadline, in ms.
+ * @details The thread runs at least every @p MOTOR_STALE_MS, with or
+ *          without frames.
+ */
+#if !defined(MOTOR_WATCHDOG_MS) || defined(__DOXYGEN__)
+#define MOTOR_WATCHDOG_MS 100
+#endif
+
+/*===========================================================================*/
+/* Derived constants and error checks.                                       */
+/*===========================================================================*/
+
+#if HAL_USE_CAN == FALSE
+#error "MOTOR requires HAL_USE_CAN"
+#endif
+
+/*===========================================================================*/
+/* Module data structures and types.                                         */
+/*===========================================================================*/
+
+/**
+ * @brief   Motor state snapshot.
+ */
+typedef struct
+{
+  tstamp_t stamp;      /**< @brief Reception time of the last frame.      */
+  int64_t position;    /**< @brief Multi-turn rotor position, counts.     */
+  int32_t velocity;    /**< @brief Filtered rotor speed, counts/s.        */
+  int16_t rpm;         /**< @brief Speed reported by the ESC.             */
+  int16_t current;     /**< @brief Torque current reported by the ESC.    */
+  uint16_t angle;      /**< @brief Single-turn rotor angle, counts.       */
+  uint8_t temperature; /**< @brief Temperature in C, zero on C610.        */
+  bool online;         /**< @brief Feedback received recently.            */
+} MotorState;
+
+/*===========================================================================*/
+/* Module macros.                                                            */
+/*===========================================================================*/
+
+/*===========================================================================*/
+/* External declarations.                                                    */
+/*===========================================================================*/
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+  void motorStart(CANDriver *canp);
+  bool motorGet(unsigned id, MotorState *msp);
+#ifdef __cplusplus
+}
+#endif
+
+/*===========================================================================*/
+/* Module inline functions.                                                  */
+/*===========================================================================*/
+
+#endif /* MOTOR_H */
+
+/** @} */
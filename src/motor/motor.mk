@@ -0,0 +1,8 @@
+# ESC feedback decoder files.
+MOTORSRC = $(COREDIR)/src/motor/motor.c
+
+MOTORINC = $(COREDIR)/src/motor
+
+# Shared variables
+ALLCSRC += $(MOTORSRC)
+ALLINC  += $(MOTORINC)
@@ -0,0 +1,314 @@
+/**
+ * @file    nn.c
+ * @brief   Static graph q7 inference runtime.
+ * @details Runs a layer list with the CMSIS-NN kernels. The activations of
+ *          all the layers share one arena, the input and output tensors of
+ *          a layer sit at opposite ends of it and swap ends at every layer,
+ *          the kernel scratch buffer follows the tensor at the bottom. The
+ *          offsets are planned once at initialization, the arena only has
+ *          to hold the largest input, scratch and output triplet instead of
+ *          every activation of the model.
+ *
+ * @addtogroup NN
+ * @{
+ */
+
+#include "ch.h"
+#include "arm_nnfunctions.h"
+#include "nn.h"
+
+/*===========================================================================*/
+/* Module local definitions.                                                 */
+/*===========================================================================*/
+
+#define NN_ALIGN(n) (((n) + 3U) & ~(size_t)3U)
+
+/*===========================================================================*/
+/* Module exported variables.                                                */
+/*===========================================================================*/
+
+/*===========================================================================*/
+/* Module local types.                                                       */
+/*===========================================================================*/
+
+/*===========================================================================*/
+/* Module local variables.                                                   */
+/*===========================================================================*/
+
+/*===========================================================================*/
+/* Module local functions.                                                   */
+/*===========================================================================*/
+
+static uint16_t nn_out_dim(uint16_t in, uint8_t k, uint8_t pad,
+                           uint8_t stride)
+{
+  return (uint16_t)((in + 2U * pad - k) / stride + 1U);
+}
+
+/**
+ * @brief   Output tensor shape of a layer.
+ */
+static void nn_out_shape(const NnLayer *lp, uint16_t shape[3])
+{
+  switch (lp->type)
+  {
+  case NN_CONV:
+  case NN_DWCONV:
+  case NN_MAXPOOL:
+  case NN_AVGPOOL:
+    shape[0] = nn_out_dim(lp->in_x, lp->kx, lp->pad_x, lp->stride_x);
+    shape[1] = nn_out_dim(lp->in_y, lp->ky, lp->pad_y, lp->stride_y);
+    shape[2] = lp->type == NN_CONV || lp->type == NN_DWCONV ? lp->out_ch
+                                                            : lp->in_ch;
+    break;
+  case NN_FC:
+  case NN_FC_OPT:
+    shape[0] = 1;
+    shape[1] = 1;
+    shape[2] = lp->out_ch;
+    break;
+  default:
+    shape[0] = lp->in_x;
+    shape[1] = lp->in_y;
+    shape[2] = lp->in_ch;
+    break;
+  }
+}
+
+static size_t nn_in_size(const NnLayer *lp)
+{
+  return (size_t)lp->in_x * lp->in_y * lp->in_ch;
+}
+
+static size_t nn_out_size(const NnLayer *lp)
+{
+  uint16_t shape[3];
+
+  nn_out_shape(lp, shape);
+  return (size_t)shape[0] * shape[1] * shape[2];
+}
+
+/**
+ * @brief   Kernel scratch buffer size in bytes.
+ */
+static size_t nn_scratch_size(const NnLayer *lp)
+{
+  switch (lp->type)
+  {
+  case NN_CONV:
+  case NN_DWCONV:
+    return 2U * 2U * lp->in_ch * lp->kx * lp->ky;
+  case NN_AVGPOOL:
+    return 2U * nn_out_dim(lp->in_x, lp->kx, lp->pad_x, lp->stride_x) *
+           lp->in_ch;
+  case NN_FC:
+  case NN_FC_OPT:
+    return 2U * nn_in_size(lp);
+  default:
+    return 0;
+  }
+}
+
+/**
+ * @brief   Plans the buffers of a model.
+ *
+ * @param[in] model     model description
+ * @param[in] size      arena size
+ * @param[out] plan     buffer offsets for that arena size, @p NULL to
+ *                      only compute the required size
+ * @return              The smallest arena size.
+ */
+static size_t nn_plan(const NnModel *model, size_t size, NnPlan *plan)
+{
+  size_t need = 0, in = nn_in_size(&model->layers[0]);
+  bool bottom = true;
+  unsigned i;
+
+  for (i = 0; i < model->nlayers; i++)
+  {
+    const NnLayer *lp = &model->layers[i];
+    size_t out = nn_out_size(lp), scratch = nn_scratch_size(lp);
+    size_t low = bottom ? in : out, high = bottom ? out : in;
+    size_t n, top;
+
+    if (lp->type == NN_RELU)
+    {
+      n = NN_ALIGN(in);
+      if (plan != NULL)
+      {
+        plan[i].in = i == 0 ? 0 : plan[i - 1].out;
+        plan[i].out = plan[i].in;
+        plan[i].scratch = 0;
+      }
+    }
+    else
+    {
+      n = NN_ALIGN(low) + NN_ALIGN(scratch) + NN_ALIGN(high);
+      if (plan != NULL && n <= size)
+      {
+        top = (size - high) & ~(size_t)3U;
+        plan[i].in = (uint16_t)(bottom ? 0 : top);
+        plan[i].out = (uint16_t)(bottom ? top : 0);
+        plan[i].scratch = (uint16_t)NN_ALIGN(low);
+      }
+      bottom = !bottom;
+    }
+
+    if (n > need)
+      need = n;
+    in = out;
+  }
+
+  return need;
+}
+
+/*===========================================================================*/
+/* Module exported functions.                                                */
+/*===========================================================================*/
+
+/**
+ * @brief   Smallest arena for a model.
+ *
+ * @param[in] model     model description
+ * @return              The arena size in bytes.
+ *
+ * @api
+ */
+size_t nnArenaSize(const NnModel *model)
+{
+  return nn_plan(model, 0, NULL);
+}
+
+/**
+ * @brief   Checks a model and plans its buffers.
+ *
+ * @param[out] np       pointer to the @p NnNet object
+ * @param[in] model     model description
+ * @param[in] arena     word aligned activation arena
+ * @param[in] size      arena size, up to 64 KiB
+ * @return              The model fits in the arena.
+ *
+ * @api
+ */
+bool nnInit(NnNet *np, const NnModel *model, void *arena, size_t size)
+{
+  uint16_t shape[3] = {0};
+  unsigned i;
+
+  chDbgCheck((model->nlayers > 0) && (model->nlayers <= NN_MAX_LAYERS) &&
+             (((uintptr_t)arena & 3U) == 0) && (size <= 0x10000U));
+
+  /* Shapes chain and kernel constraints.*/
+  for (i = 0; i < model->nlayers; i++)
+  {
+    const NnLayer *lp = &model->layers[i];
+
+    if (i > 0)
+      chDbgCheck((lp->in_x == shape[0] && lp->in_y == shape[1] &&
+                  lp->in_ch == shape[2]) ||
+                 ((lp->type == NN_FC || lp->type == NN_FC_OPT) &&
+                  nn_in_size(lp) == (size_t)shape[0] * shape[1] * shape[2]));
+    chDbgCheck((lp->type != NN_DWCONV) ||
+               ((lp->in_ch == lp->out_ch) && ((lp->in_ch & 1U) == 0)));
+    chDbgCheck(((lp->type != NN_MAXPOOL) && (lp->type != NN_AVGPOOL)) ||
+               ((lp->in_x == lp->in_y) && (lp->kx == lp->ky) &&
+                (lp->pad_x == lp->pad_y) && (lp->stride_x == lp->stride_y)));
+    nn_out_shape(lp, shape);
+  }
+
+  np->model = model;
+  np->arena = arena;
+  return nn_plan(model, size, np->plan) <= size;
+}
+
+/**
+ * @brief   Input tensor of the model.
+ *
+ * @param[in] np        pointer to the @p NnNet object
+ * @return              The buffer to write the input into before
+ *                      @p nnRun().
+ *
+ * @api
+ */
+q7_t *nnInput(NnNet *np)
+{
+  return (q7_t *)&np->arena[np->plan[0].in];
+}
+
+/**
+ * @brief   Runs an inference.
+ *
+ * @param[in] np        pointer to the @p NnNet object
+ * @return              The output tensor, valid until the input is
+ *                      written again.
+ *
+ * @api
+ */
+const q7_t *nnRun(NnNet *np)
+{
+  const NnModel *model = np->model;
+  unsigned i;
+
+  for (i = 0; i < model->nlayers; i++)
+  {
+    const NnLayer *lp = &model->layers[i];
+    q7_t *in = (q7_t *)&np->arena[np->plan[i].in];
+    q7_t *out = (q7_t *)&np->arena[np->plan[i].out];
+    void *scratch = &np->arena[np->plan[i].scratch];
+    uint16_t shape[3];
+
+    nn_out_shape(lp, shape);
+    switch (lp->type)
+    {
+    case NN_CONV:
+      if ((lp->in_ch & 3U) == 0 && (lp->out_ch & 1U) == 0)
+        (void)arm_convolve_HWC_q7_fast_nonsquare(
+            in, lp->in_x, lp->in_y, lp->in_ch, lp->weights, lp->out_ch,
+            lp->kx, lp->ky, lp->pad_x, lp->pad_y, lp->stride_x, lp->stride_y,
+            lp->bias, lp->bias_shift, lp->out_shift, out, shape[0], shape[1],
+            scratch, NULL);
+      else
+        (void)arm_convolve_HWC_q7_basic_nonsquare(
+            in, lp->in_x, lp->in_y, lp->in_ch, lp->weights, lp->out_ch,
+            lp->kx, lp->ky, lp->pad_x, lp->pad_y, lp->stride_x, lp->stride_y,
+            lp->bias, lp->bias_shift, lp->out_shift, out, shape[0], shape[1],
+            scratch, NULL);
+      break;
+    case NN_DWCONV:
+      (void)arm_depthwise_separable_conv_HWC_q7_nonsquare(
+          in, lp->in_x, lp->in_y, lp->in_ch, lp->weights, lp->out_ch, lp->kx,
+          lp->ky, lp->pad_x, lp->pad_y, lp->stride_x, lp->stride_y, lp->bias,
+          lp->bias_shift, lp->out_shift, out, shape[0], shape[1], scratch,
+          NULL);
+      break;
+    case NN_MAXPOOL:
+      arm_maxpool_q7_HWC(in, lp->in_x, lp->in_ch, lp->kx, lp->pad_x,
+                         lp->stride_x, shape[0], scratch, out);
+      break;
+    case NN_AVGPOOL:
+      arm_avepool_q7_HWC(in, lp->in_x, lp->in_ch, lp->kx, lp->pad_x,
+                         lp->stride_x, shape[0], scratch, out);
+      break;
+    case NN_FC:
+      (void)arm_fully_connected_q7(in, lp->weights, (uint16_t)nn_in_size(lp),
+                                   lp->out_ch, lp->bias_shift, lp->out_shift,
+                                   lp->bias, out, scratch);
+      break;
+    case NN_FC_OPT:
+      (void)arm_fully_connected_q7_opt(
+          in, lp->weights, (uint16_t)nn_in_size(lp), lp->out_ch,
+          lp->bias_shift, lp->out_shift, lp->bias, out, scratch);
+      break;
+    case NN_RELU:
+      arm_relu_q7(in, (uint16_t)nn_in_size(lp));
+      break;
+    case NN_SOFTMAX:
+      arm_softmax_q7(in, (uint16_t)nn_in_size(lp), out);
+      break;
+    }
+  }
+
+  return (const q7_t *)&np->arena[np->plan[model->nlayers - 1].out];
+}
+
+/** @} */
@@ -0,0 +1,136 @@
+/**
+ * @file    nn.h
+ * @brief   Static graph q7 inference runtime.
+ *
+ * @addtogroup NN
+ * @{
+ */
+
+#ifndef NN_H
+#define NN_H
+
+#include "ch.h"
+#include "arm_math.h"
+
+/*===========================================================================*/
+/* Module constants.                                                         */
+/*===========================================================================*/
+
+/*===========================================================================*/
+/* Module pre-compile time settings.                                         */
+/*===========================================================================*/
+
+/**
+ * @brief   Largest number of layers in a model.
+ */
+#if !defined(NN_MAX_LAYERS) || defined(__DOXYGEN__)
+#define NN_MAX_LAYERS 12
+#endif
+
+/*===========================================================================*/
+/* Derived constants and error checks.                                       */
+/*===========================================================================*/
+
+/*===========================================================================*/
+/* Module data structures and types.                                         */
+/*===========================================================================*/
+
+/**
+ * @brief   Layer types.
+ */
+typedef enum
+{
+  NN_CONV,    /**< @brief Convolution, weights out_ch x ky x kx x in_ch.  */
+  NN_DWCONV,  /**< @brief Depthwise convolution, in_ch equal to out_ch
+                          and even, weights ky x kx x in_ch.            */
+  NN_MAXPOOL, /**< @brief Max pooling, square.                          */
+  NN_AVGPOOL, /**< @brief Average pooling, square.                      */
+  NN_FC,      /**< @brief Fully connected, weights out_ch x inputs.     */
+  NN_FC_OPT,  /**< @brief Fully connected, weights interleaved for
+                          @p arm_fully_connected_q7_opt().              */
+  NN_RELU,    /**< @brief ReLU, in place.                               */
+  NN_SOFTMAX  /**< @brief Softmax.                                      */
+} NnLayerType;
+
+/**
+ * @brief   Layer description.
+ * @details Tensors are HWC q7, the input shape of a layer must match the
+ *          output shape of the previous one. Fully connected layers take
+ *          the whole input tensor as a vector.
+ */
+typedef struct
+{
+  NnLayerType type;     /**< @brief Layer type.                         */
+  uint16_t in_x;        /**< @brief Input width.                        */
+  uint16_t in_y;        /**< @brief Input height.                       */
+  uint16_t in_ch;       /**< @brief Input channels.                     */
+  uint16_t out_ch;      /**< @brief Filters or outputs, unused by the
+                                    other layers.                       */
+  uint8_t kx;           /**< @brief Kernel width.                       */
+  uint8_t ky;           /**< @brief Kernel height.                      */
+  uint8_t pad_x;        /**< @brief Horizontal padding.                 */
+  uint8_t pad_y;        /**< @brief Vertical padding.                   */
+  uint8_t stride_x;     /**< @brief Horizontal stride.                  */
+  uint8_t stride_y;     /**< @brief Vertical stride.                    */
+  uint8_t bias_shift;   /**< @brief Bias left shift.                    */
+  uint8_t out_shift;    /**< @brief Output right shift.                 */
+  const q7_t *weights;  /**< @brief Weights.                            */
+  const q7_t *bias;     /**< @brief Bias, one per output channel.       */
+} NnLayer;
+
+/**
+ * @brief   Model description, usually in flash.
+ */
+typedef struct
+{
+  const NnLayer *layers; /**< @brief Layers in execution order.         */
+  unsigned nlayers;      /**< @brief Number of layers.                  */
+} NnModel;
+
+/**
+ * @brief   Buffer offsets of a layer in the arena.
+ */
+typedef struct
+{
+  uint16_t in;      /**< @brief Input tensor.                           */
+  uint16_t out;     /**< @brief Output tensor.                          */
+  uint16_t scratch; /**< @brief Kernel scratch buffer.                  */
+} NnPlan;
+
+/**
+ * @brief   Runtime object.
+ */
+typedef struct
+{
+  const NnModel *model;         /**< @brief Model.                      */
+  uint8_t *arena;               /**< @brief Shared activation arena.    */
+  NnPlan plan[NN_MAX_LAYERS];   /**< @brief Buffer plan.                */
+} NnNet;
+
+/*===========================================================================*/
+/* Module macros.                                                            */
+/*===========================================================================*/
+
+/*===========================================================================*/
+/* External declarations.                                                    */
+/*===========================================================================*/
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+  size_t nnArenaSize(const NnModel *model);
+  bool nnInit(NnNet *np, const NnModel *model, void *arena, size_t size);
+  q7_t *nnInput(NnNet *np);
+  const q7_t *nnRun(NnNet *np);
+#ifdef __cplusplus
+}
+#endif
+
+/*===========================================================================*/
+/* Module inline functions.                                                  */
+/*===========================================================================*/
+
+#endif /* NN_H */
+
+/** @} */
@@ -0,0 +1,21 @@
+# Inference runtime files.
+NNSRC = $(COREDIR)/src/nn/nn.c \
+        $(COREDIR)/CMSIS/NN/Source/ActivationFunctions/arm_relu_q7.c \
+        $(COREDIR)/CMSIS/NN/Source/ConvolutionFunctions/arm_convolve_HWC_q7_basic_nonsquare.c \
+        $(COREDIR)/CMSIS/NN/Source/ConvolutionFunctions/arm_convolve_HWC_q7_fast_nonsquare.c \
+        $(COREDIR)/CMSIS/NN/Source/ConvolutionFunctions/arm_depthwise_separable_conv_HWC_q7_nonsquare.c \
+        $(COREDIR)/CMSIS/NN/Source/ConvolutionFunctions/arm_nn_mat_mult_kernel_q7_q15.c \
+        $(COREDIR)/CMSIS/NN/Source/ConvolutionFunctions/arm_nn_mat_mult_kernel_q7_q15_reordered.c \
+        $(COREDIR)/CMSIS/NN/Source/FullyConnectedFunctions/arm_fully_connected_q7.c \
+        $(COREDIR)/CMSIS/NN/Source/FullyConnectedFunctions/arm_fully_connected_q7_opt.c \
+        $(COREDIR)/CMSIS/NN/Source/NNSupportFunctions/arm_q7_to_q15_no_shift.c \
+        $(COREDIR)/CMSIS/NN/Source/NNSupportFunctions/arm_q7_to_q15_reordered_no_shift.c \
+        $(COREDIR)/CMSIS/NN/Source/PoolingFunctions/arm_pool_q7_HWC.c \
+        $(COREDIR)/CMSIS/NN/Source/SoftmaxFunctions/arm_softmax_q7.c
+
+NNINC = $(COREDIR)/src/nn \
+        $(COREDIR)/CMSIS/NN/Include
+
+# Shared variables
+ALLCSRC += $(NNSRC)
+ALLINC  += $(NNINC)
@@ -0,0 +1,281 @@
+/**
+ * @file    objreg.c
+ * @brief   Static named object registry.
+ * @details A flash table of named objects built by the linker from the
+ *          entries of every module, in place of the factory lists that
+ *          allocate from the heap and search names one by one. At start
+ *          an open addressing hash table of entry indexes is filled in
+ *          RAM, a lookup hashes the name and usually compares a single
+ *          string.
+ *
+ * @addtogroup OBJREG
+ * @{
+ */
+
+#include <string.h>
+
+#include "ch.h"
+#include "hal.h"
+#include "chprintf.h"
+#include "shell.h"
+#include "objreg.h"
+
+/*===========================================================================*/
+/* Module local definitions.                                                 */
+/*===========================================================================*/
+
+#define OBJREG_MASK (OBJREG_HASH_SIZE - 1U)
+
+/*===========================================================================*/
+/* Module exported variables.                                                */
+/*===========================================================================*/
+
+/*===========================================================================*/
+/* Module local types.                                                       */
+/*===========================================================================*/
+
+/*===========================================================================*/
+/* Module local variables.                                                   */
+/*===========================================================================*/
+
+/**
+ * @brief   Registry bounds, from the linker script.
+ */
+extern const ObjRegEntry __objreg_base__[], __objreg_end__[];
+
+/**
+ * @brief   As many entries as the hash table can take, the linker script
+ *          checks the registry against its size. Not loaded.
+ */
+static const ObjRegEntry objreg_limit[OBJREG_HASH_SIZE - 1U]
+    __attribute__((used, section(".objreg_limit")));
+
+/**
+ * @brief   Hash table, entry index plus one, zero when free.
+ */
+static uint16_t objreg_table[OBJREG_HASH_SIZE];
+
+/*===========================================================================*/
+/* Module local functions.                                                   */
+/*===========================================================================*/
+
+/**
+ * @brief   FNV-1a hash of a name.
+ */
+static uint32_t objreg_hash(const char *name)
+{
+  uint32_t h = 2166136261U;
+
+  while (*name != '\0')
+  {
+    h ^= (uint8_t)*name++;
+    h *= 16777619U;
+  }
+
+  return h;
+}
+
+static const char *objreg_type_name(ObjRegType type)
+{
+  static const char *const names[] = {"buffer", "semaphore", "bsemaphore",
+                                      "mailbox", "fifo", "pipe"};
+
+  return (unsigned)type < sizeof(names) / sizeof(names[0]) ? names[type]
+                                                           : "?";
+}
+
+/**
+ * @brief   Prints one entry and the state of its object.
+ * @details The state is read with the kernel locked and printed after.
+ */
+static void objreg_print_entry(BaseSequentialStream *chp,
+                               const ObjRegEntry *ep)
+{
+  long a = 0, b = 0, c = 0;
+
+  chprintf(chp, "%-16s %-10s %08lx ", ep->name, objreg_type_name(ep->type),
+           (unsigned long)(uintptr_t)ep->object);
+
+  chSysLock();
+  switch (ep->type)
+  {
+  case OBJREG_SEMAPHORE:
+    a = chSemGetCounterI((semaphore_t *)ep->object);
+    break;
+  case OBJREG_BSEMAPHORE:
+    a = chBSemGetStateI((binary_semaphore_t *)ep->object);
+    break;
+#if CH_CFG_USE_MAILBOXES == TRUE
+  case OBJREG_MAILBOX:
+    a = (long)chMBGetUsedCountI((mailbox_t *)ep->object);
+    b = (long)chMBGetSizeI((mailbox_t *)ep->object);
+    break;
+#endif
+#if CH_CFG_USE_OBJ_FIFOS == TRUE
+  case OBJREG_FIFO:
+    a = (long)chMBGetUsedCountI(&((objects_fifo_t *)ep->object)->mbx);
+    b = (long)chMBGetSizeI(&((objects_fifo_t *)ep->object)->mbx);
+    c = chSemGetCounterI(&((objects_fifo_t *)ep->object)->free.sem);
+    break;
+#endif
+#if CH_CFG_USE_PIPES == TRUE
+  case OBJREG_PIPE:
+    a = (long)chPipeGetUsedCount((pipe_t *)ep->object);
+    b = (long)chPipeGetSize((pipe_t *)ep->object);
+    break;
+#endif
+  default:
+    a = (long)ep->size;
+    break;
+  }
+  chSysUnlock();
+
+  switch (ep->type)
+  {
+  case OBJREG_SEMAPHORE:
+    chprintf(chp, "count %ld", a);
+    break;
+  case OBJREG_BSEMAPHORE:
+    chprintf(chp, "%s", a ? "taken" : "ready");
+    break;
+  case OBJREG_MAILBOX:
+  case OBJREG_PIPE:
+    chprintf(chp, "used %ld/%ld", a, b);
+    break;
+  case OBJREG_FIFO:
+    chprintf(chp, "queued %ld/%ld free %ld", a, b, c);
+    break;
+  default:
+    chprintf(chp, "size %ld", a);
+    break;
+  }
+  chprintf(chp, SHELL_NEWLINE_STR);
+}
+
+/*===========================================================================*/
+/* Module exported functions.                                                */
+/*===========================================================================*/
+
+/**
+ * @brief   Builds the hash table.
+ *
+ * @init
+ */
+void objregInit(void)
+{
+  unsigned i, n = objregCount();
+
+  /* Checked at link time as well, see objreg_limit.*/
+  chDbgAssert(n < OBJREG_HASH_SIZE, "registry hash table too small");
+
+  memset(objreg_table, 0, sizeof(objreg_table));
+  for (i = 0; i < n; i++)
+  {
+    uint32_t h = objreg_hash(__objreg_base__[i].name) & OBJREG_MASK;
+
+    chDbgAssert((i == 0) || (strcmp(__objreg_base__[i - 1].name,
+                                    __objreg_base__[i].name) != 0),
+                "duplicate registry name");
+    while (objreg_table[h] != 0)
+      h = (h + 1U) & OBJREG_MASK;
+    objreg_table[h] = (uint16_t)(i + 1U);
+  }
+}
+
+/**
+ * @brief   Looks an object up by name.
+ *
+ * @param[in] name      object name
+ * @return              The entry, @p NULL if not found.
+ *
+ * @api
+ */
+const ObjRegEntry *objregFind(const char *name)
+{
+  uint32_t h = objreg_hash(name) & OBJREG_MASK;
+  unsigned i;
+
+  /* The table always keeps a free slot, the probe ends there.*/
+  for (i = 0; i < OBJREG_HASH_SIZE && objreg_table[h] != 0; i++)
+  {
+    const ObjRegEntry *ep = &__objreg_base__[objreg_table[h] - 1U];
+
+    if (strcmp(ep->name, name) == 0)
+      return ep;
+    h = (h + 1U) & OBJREG_MASK;
+  }
+
+  return NULL;
+}
+
+/**
+ * @brief   Looks an object of a given type up by name.
+ *
+ * @param[in] name      object name
+ * @param[in] type      expected object type
+ * @return              The object, @p NULL if not found or of another
+ *                      type.
+ *
+ * @api
+ */
+void *objregGet(const char *name, ObjRegType type)
+{
+  const ObjRegEntry *ep = objregFind(name);
+
+  return ep != NULL && ep->type == type ? ep->object : NULL;
+}
+
+/**
+ * @brief   First entry, the others follow it sorted by name.
+ *
+ * @return              The entry array, @p objregCount() long.
+ *
+ * @api
+ */
+const ObjRegEntry *objregFirst(void)
+{
+  return __objreg_base__;
+}
+
+/**
+ * @brief   Number of entries.
+ *
+ * @api
+ */
+unsigned objregCount(void)
+{
+  return (unsigned)(__objreg_end__ - __objreg_base__);
+}
+
+/**
+ * @brief   Lists the registered objects and their state.
+ *
+ * @param[in] chp       output stream
+ * @param[in] name      single object to print, @p NULL for all of them
+ *
+ * @api
+ */
+void objregPrint(BaseSequentialStream *chp, const char *name)
+{
+  const ObjRegEntry *ep;
+  unsigned i, n = objregCount();
+
+  if (name != NULL)
+  {
+    ep = objregFind(name);
+    if (ep == NULL)
+    {
+      chprintf(chp, "%s not found" SHELL_NEWLINE_STR, name);
+      return;
+    }
+    objreg_print_entry(chp, ep);
+    return;
+  }
+
+  chprintf(chp, "%-16s %-10s %-8s state" SHELL_NEWLINE_STR, "name", "type",
+           "address");
+  for (i = 0; i < n; i++)
+    objreg_print_entry(chp, &__objreg_base__[i]);
+}
+
+/** @} */
@@ -0,0 +1,111 @@
+/**
+ * @file    objreg.h
+ * @brief   Static named object registry.
+ *
+ * @addtogroup OBJREG
+ * @{
+ */
+
+#ifndef OBJREG_H
+#define OBJREG_H
+
+#include "ch.h"
+#include "hal.h"
+
+/*===========================================================================*/
+/* Module constants.                                                         */
+/*===========================================================================*/
+
+/*===========================================================================*/
+/* Module pre-compile time settings.                                         */
+/*===========================================================================*/
+
+/**
+ * @brief   Hash table size, a power of two larger than the number of
+ *          registered objects.
+ * @details Two bytes of RAM per slot, lookups stay short while the table
+ *          is at most half full. The link fails when it cannot take every
+ *          registered object.
+ */
+#if !defined(OBJREG_HASH_SIZE) || defined(__DOXYGEN__)
+#define OBJREG_HASH_SIZE 64
+#endif
+
+/*===========================================================================*/
+/* Derived constants and error checks.                                       */
+/*===========================================================================*/
+
+#if (OBJREG_HASH_SIZE & (OBJREG_HASH_SIZE - 1)) != 0
+#error "OBJREG_HASH_SIZE must be a power of two"
+#endif
+
+/*===========================================================================*/
+/* Module data structures and types.                                         */
+/*===========================================================================*/
+
+/**
+ * @brief   Registered object types.
+ */
+typedef enum
+{
+  OBJREG_BUFFER,      /**< @brief Raw memory.                            */
+  OBJREG_SEMAPHORE,   /**< @brief @p semaphore_t.                        */
+  OBJREG_BSEMAPHORE,  /**< @brief @p binary_semaphore_t.                 */
+  OBJREG_MAILBOX,     /**< @brief @p mailbox_t.                          */
+  OBJREG_FIFO,        /**< @brief @p objects_fifo_t.                     */
+  OBJREG_PIPE         /**< @brief @p pipe_t.                             */
+} ObjRegType;
+
+/**
+ * @brief   Registry entry, placed in flash by the linker.
+ */
+typedef struct
+{
+  const char *name;   /**< @brief Object name.                          */
+  void *object;       /**< @brief Object.                               */
+  uint32_t size;      /**< @brief Object size.                          */
+  ObjRegType type;    /**< @brief Object type.                          */
+} ObjRegEntry;
+
+/*===========================================================================*/
+/* Module macros.                                                            */
+/*===========================================================================*/
+
+/**
+ * @brief   Registers a statically allocated object under its name.
+ * @details The entry goes into its own input section, the linker gathers
+ *          all of them sorted by name. Names must be unique.
+ *
+ * @param[in] obj       the object variable, its name is the registry name
+ * @param[in] type      object type
+ */
+#define OBJREG_ADD(obj, type)                                             \
+  static const ObjRegEntry objreg_##obj                                   \
+      __attribute__((used, section(".objreg." #obj))) =                   \
+          {#obj, (void *)&(obj), sizeof(obj), (type)}
+
+/*===========================================================================*/
+/* External declarations.                                                    */
+/*===========================================================================*/
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+  void objregInit(void);
+  const ObjRegEntry *objregFind(const char *name);
+  void *objregGet(const char *name, ObjRegType type);
+  const ObjRegEntry *objregFirst(void);
+  unsigned objregCount(void);
+  void objregPrint(BaseSequentialStream *chp, const char *name);
+#ifdef __cplusplus
+}
+#endif
+
+/*===========================================================================*/
+/* Module inline functions.                                                  */
+/*===========================================================================*/
+
+#endif /* OBJREG_H */
+
+/** @} */
@@ -0,0 +1,8 @@
+# Static object registry files.
+OBJREGSRC = $(COREDIR)/src/objreg/objreg.c
+
+OBJREGINC = $(COREDIR)/src/objreg
+
+# Shared variables
+ALLCSRC += $(OBJREGSRC)
+ALLINC  += $(OBJREGINC)
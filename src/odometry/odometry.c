@@ -0,0 +1,172 @@
+/**
+ * @file    odometry.c
+ * @brief   Chassis odometry.
+ * @details Dead reckoning of the wheel speeds rotated by the gyro heading,
+ *          with the gyro bias estimated by an extended Kalman filter. The
+ *          yaw rate from the wheels is the only measurement, it observes
+ *          the bias alone and the heading through their covariance, so the
+ *          update touches a single covariance column. The heading wraps
+ *          naturally as rad / pi in Q31, positions span +/-65 m in Q15 mm.
+ *
+ * @addtogroup ODOMETRY
+ * @{
+ */
+
+#include "ch.h"
+#include "odometry.h"
+
+/*===========================================================================*/
+/* Module local definitions.                                                 */
+/*===========================================================================*/
+
+#define ODOM_PI_Q29 1686629713
+#define ODOM_INV_PI_Q31 683565276
+#define ODOM_INV_2PI_Q31 341782638
+
+/*===========================================================================*/
+/* Module exported variables.                                                */
+/*===========================================================================*/
+
+/*===========================================================================*/
+/* Module local types.                                                       */
+/*===========================================================================*/
+
+/*===========================================================================*/
+/* Module local variables.                                                   */
+/*===========================================================================*/
+
+/*===========================================================================*/
+/* Module local functions.                                                   */
+/*===========================================================================*/
+
+/**
+ * @brief   Integration step.
+ *
+ * @param[in] op        pointer to the @p Odometry object
+ * @param[in] sp        sample ending the step
+ * @param[in] dt        step length, seconds in Q31
+ */
+static void odom_step(Odometry *op, const OdomSample *sp, q31_t dt)
+{
+  const OdomConfig *cfg = op->config;
+  q31_t *x = op->ekf.x;
+  q31_t g[ODOM_STATES * ODOM_STATES] = {0};
+  q31_t q[ODOM_STATES];
+  EkfTerm h;
+  q31_t s, c, wx, wy, rate, dth;
+  q63_t innov;
+
+  /* World frame velocity, mm/s in Q16.*/
+  arm_sin_cos_q31(x[ODOM_THETA], &s, &c);
+  wx = (q31_t)(((q63_t)sp->vx * c - (q63_t)sp->vy * s) >> 15);
+  wy = (q31_t)(((q63_t)sp->vx * s + (q63_t)sp->vy * c) >> 15);
+
+  /* Jacobian minus the identity, at the state before the step.*/
+  g[ODOM_X * ODOM_STATES + ODOM_THETA] =
+      (q31_t)(((((q63_t)-wy * dt) >> 32) * ODOM_PI_Q29) >> 29);
+  g[ODOM_Y * ODOM_STATES + ODOM_THETA] =
+      (q31_t)(((((q63_t)wx * dt) >> 32) * ODOM_PI_Q29) >> 29);
+  g[ODOM_THETA * ODOM_STATES + ODOM_BIAS] =
+      -(q31_t)(((q63_t)dt * ODOM_INV_2PI_Q31) >> 31);
+
+  q[ODOM_X] = (q31_t)(((q63_t)cfg->q_pos * dt) >> 31);
+  q[ODOM_Y] = q[ODOM_X];
+  q[ODOM_THETA] = (q31_t)(((q63_t)cfg->q_theta * dt) >> 31);
+  q[ODOM_BIAS] = (q31_t)(((q63_t)cfg->q_bias * dt) >> 31);
+  ekfPredict(&op->ekf, g, q);
+
+  x[ODOM_X] = clip_q63_to_q31(x[ODOM_X] + (((q63_t)wx * dt) >> 32));
+  x[ODOM_Y] = clip_q63_to_q31(x[ODOM_Y] + (((q63_t)wy * dt) >> 32));
+  rate = sp->gyro - (x[ODOM_BIAS] >> 8);
+  dth = (q31_t)(((q63_t)rate * dt) >> 24);
+  x[ODOM_THETA] = (q31_t)((uint32_t)x[ODOM_THETA] +
+                          (uint32_t)(((q63_t)dth * ODOM_INV_PI_Q31) >> 31));
+
+  /* Wheel yaw rate against the corrected gyro, in the bias units.*/
+  innov = ((q63_t)sp->wheel_rate - sp->gyro) * 256 + x[ODOM_BIAS];
+  h.index = ODOM_BIAS;
+  h.value = INT32_MIN;
+  (void)ekfUpdate(&op->ekf, &h, 1, clip_q63_to_q31(innov), cfg->r_rate);
+}
+
+/*===========================================================================*/
+/* Module exported functions.                                                */
+/*===========================================================================*/
+
+/**
+ * @brief   Initializes the odometry at the origin.
+ *
+ * @param[out] op       pointer to the @p Odometry object
+ * @param[in] config    pointer to the odometry configuration
+ *
+ * @api
+ */
+void odomInit(Odometry *op, const OdomConfig *config)
+{
+  static const q31_t x0[ODOM_STATES] = {0};
+  q31_t p0[ODOM_STATES] = {0};
+
+  p0[ODOM_BIAS] = config->p_bias;
+  op->config = config;
+  op->last = 0;
+  ekfInit(&op->ekf, ODOM_STATES, x0, p0);
+  op->out.x = 0;
+  op->out.y = 0;
+  op->out.theta = 0;
+  op->out.bias = 0;
+}
+
+/**
+ * @brief   Integrates a batch of samples.
+ * @details The pose is published once per batch.
+ *
+ * @param[in] op        pointer to the @p Odometry object
+ * @param[in] samples   samples in time order
+ * @param[in] n         number of samples
+ *
+ * @api
+ */
+void odomUpdate(Odometry *op, const OdomSample *samples, unsigned n)
+{
+  const q31_t *x = op->ekf.x;
+  unsigned i;
+
+  for (i = 0; i < n; i++)
+  {
+    const OdomSample *sp = &samples[i];
+    tstamp_t dts;
+
+    if (op->last != 0)
+    {
+      dts = sp->t - op->last;
+      if (dts > US2TS(ODOM_MAX_DT_US))
+        dts = US2TS(ODOM_MAX_DT_US);
+      odom_step(op, sp, TS2Q31(dts));
+    }
+    op->last = sp->t;
+  }
+
+  chSysLock();
+  op->out.x = x[ODOM_X];
+  op->out.y = x[ODOM_Y];
+  op->out.theta = x[ODOM_THETA];
+  op->out.bias = x[ODOM_BIAS];
+  chSysUnlock();
+}
+
+/**
+ * @brief   Latest pose.
+ *
+ * @param[in] op        pointer to the @p Odometry object
+ * @param[out] pose     estimated pose
+ *
+ * @api
+ */
+void odomGetPose(Odometry *op, OdomPose *pose)
+{
+  chSysLock();
+  *pose = op->out;
+  chSysUnlock();
+}
+
+/** @} */
@@ -0,0 +1,160 @@
+/**
+ * @file    odometry.h
+ * @brief   Chassis odometry.
+ *
+ * @addtogroup ODOMETRY
+ * @{
+ */
+
+#ifndef ODOMETRY_H
+#define ODOMETRY_H
+
+#include "ch.h"
+#include "arm_math.h"
+#include "timestamp.h"
+#include "ekf.h"
+
+/*===========================================================================*/
+/* Module constants.                                                         */
+/*===========================================================================*/
+
+/**
+ * @name    Filter states
+ * @{
+ */
+#define ODOM_X 0     /**< @brief X position, mm in Q15.                   */
+#define ODOM_Y 1     /**< @brief Y position, mm in Q15.                   */
+#define ODOM_THETA 2 /**< @brief Heading, rad / pi in Q31.                */
+#define ODOM_BIAS 3  /**< @brief Gyro bias, rad/s in Q32.                 */
+#define ODOM_STATES 4
+/** @} */
+
+/*===========================================================================*/
+/* Module pre-compile time settings.                                         */
+/*===========================================================================*/
+
+/**
+ * @brief   Longest integration step.
+ * @details Longer gaps between samples are integrated as this long.
+ */
+#if !defined(ODOM_MAX_DT_US) || defined(__DOXYGEN__)
+#define ODOM_MAX_DT_US 20000
+#endif
+
+/*===========================================================================*/
+/* Derived constants and error checks.                                       */
+/*===========================================================================*/
+
+#if ODOM_MAX_DT_US >= 1000000
+#error "ODOM_MAX_DT_US must be shorter than one second"
+#endif
+
+#if EKF_MAX_STATES < ODOM_STATES
+#error "EKF_MAX_STATES too small for the odometry filter"
+#endif
+
+/*===========================================================================*/
+/* Module data structures and types.                                         */
+/*===========================================================================*/
+
+/**
+ * @brief   Odometry configuration.
+ * @details Variances are in the units of the filter states, see the
+ *          @p ODOM_VAR_POS(), @p ODOM_VAR_ANGLE() and @p ODOM_VAR_RATE()
+ *          macros.
+ */
+typedef struct
+{
+  q31_t q_pos;   /**< @brief Position variance growth per second.       */
+  q31_t q_theta; /**< @brief Heading variance growth per second.        */
+  q31_t q_bias;  /**< @brief Gyro bias variance growth per second.      */
+  q31_t p_bias;  /**< @brief Initial gyro bias variance.                */
+  q31_t r_rate;  /**< @brief Wheel yaw rate variance.                   */
+} OdomConfig;
+
+/**
+ * @brief   Chassis sample.
+ */
+typedef struct
+{
+  tstamp_t t;         /**< @brief Sampling time.                        */
+  int32_t vx;         /**< @brief Forward speed from the wheels, mm/s.  */
+  int32_t vy;         /**< @brief Left speed from the wheels, mm/s.     */
+  q31_t gyro;         /**< @brief Gyro yaw rate, rad/s in Q24.          */
+  q31_t wheel_rate;   /**< @brief Yaw rate from the wheels, rad/s in
+                                  Q24.                                  */
+} OdomSample;
+
+/**
+ * @brief   Estimated pose.
+ */
+typedef struct
+{
+  int32_t x;     /**< @brief X position, mm in Q15.                     */
+  int32_t y;     /**< @brief Y position, mm in Q15.                     */
+  q31_t theta;   /**< @brief Heading, rad / pi in Q31.                  */
+  q31_t bias;    /**< @brief Gyro bias, rad/s in Q32.                   */
+} OdomPose;
+
+/**
+ * @brief   Odometry object.
+ */
+typedef struct
+{
+  const OdomConfig *config; /**< @brief Odometry configuration.         */
+  tstamp_t last;            /**< @brief Time of the last sample, zero
+                                        before the first one.           */
+  Ekf ekf;                  /**< @brief Filter.                         */
+  OdomPose out;             /**< @brief Published pose.                 */
+} Odometry;
+
+/*===========================================================================*/
+/* Module macros.                                                            */
+/*===========================================================================*/
+
+/**
+ * @name    Variance constants
+ * @note    Meant for constant expressions only.
+ * @{
+ */
+/**
+ * @brief   Position variance from its standard deviation in mm.
+ */
+#define ODOM_VAR_POS(mm)                                                  \
+  ((q31_t)((mm) * (mm) / (65536.0 * 65536.0) * 2147483648.0))
+
+/**
+ * @brief   Heading variance from its standard deviation in rad.
+ */
+#define ODOM_VAR_ANGLE(rad)                                               \
+  ((q31_t)((rad) * (rad) / (3.14159265358979 * 3.14159265358979) *        \
+           2147483648.0))
+
+/**
+ * @brief   Yaw rate variance from its standard deviation in rad/s.
+ */
+#define ODOM_VAR_RATE(rads) ((q31_t)(4.0 * (rads) * (rads) * 2147483648.0))
+/** @} */
+
+/*===========================================================================*/
+/* External declarations.                                                    */
+/*===========================================================================*/
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+  void odomInit(Odometry *op, const OdomConfig *config);
+  void odomUpdate(Odometry *op, const OdomSample *samples, unsigned n);
+  void odomGetPose(Odometry *op, OdomPose *pose);
+#ifdef __cplusplus
+}
+#endif
+
+/*===========================================================================*/
+/* Module inline functions.                                                  */
+/*===========================================================================*/
+
+#endif /* ODOMETRY_H */
+
+/** @} */
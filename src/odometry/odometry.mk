@@ -0,0 +1,8 @@
+# Chassis odometry files.
+ODOMETRYSRC = $(COREDIR)/src/odometry/odometry.c
+
+ODOMETRYINC = $(COREDIR)/src/odometry
+
+# Shared variables
+ALLCSRC += $(ODOMETRYSRC)
+ALLINC  += $(ODOMETRYINC)
@@ -0,0 +1,320 @@
+/**
+ * @file    pid.c
+ * @brief   Fixed-point PID and cascade PID controllers.
+ * @details The proportional and integral terms use the CMSIS-DSP
+ *          incremental PID, the integrator is the previous output so
+ *          clamping it to the output limits is the anti-windup. The
+ *          derivative term is computed apart and low-pass filtered, it is
+ *          added together with the feed-forward after the integrator and
+ *          the sum is saturated again.
+ *
+ * @addtogroup PID
+ * @{
+ */
+
+#include "ch.h"
+#include "pid.h"
+
+/*===========================================================================*/
+/* Module local definitions.                                                 */
+/*===========================================================================*/
+
+/*===========================================================================*/
+/* Module exported variables.                                                */
+/*===========================================================================*/
+
+/*===========================================================================*/
+/* Module local types.                                                       */
+/*===========================================================================*/
+
+/*===========================================================================*/
+/* Module local variables.                                                   */
+/*===========================================================================*/
+
+/*===========================================================================*/
+/* Module local functions.                                                   */
+/*===========================================================================*/
+
+static inline q31_t clamp_q31(q63_t x, q31_t min, q31_t max)
+{
+  if (x < min)
+    return min;
+  if (x > max)
+    return max;
+  return (q31_t)x;
+}
+
+static inline q15_t clamp_q15(q31_t x, q15_t min, q15_t max)
+{
+  if (x < min)
+    return min;
+  if (x > max)
+    return max;
+  return (q15_t)x;
+}
+
+/*===========================================================================*/
+/* Module exported functions.                                                */
+/*===========================================================================*/
+
+/**
+ * @brief   Initializes a Q31 controller.
+ *
+ * @param[out] pidp     pointer to the @p PidQ31 object
+ * @param[in] config    pointer to the controller configuration
+ *
+ * @api
+ */
+void pidQ31Init(PidQ31 *pidp, const PidQ31Config *config)
+{
+  chDbgCheck(config->out_min < config->out_max);
+
+  pidp->config = config;
+  pidp->pi.Kp = config->kp;
+  pidp->pi.Ki = config->ki;
+  pidp->pi.Kd = 0;
+  arm_pid_init_q31(&pidp->pi, 1);
+  pidp->d = 0;
+}
+
+/**
+ * @brief   Clears the state of a Q31 controller.
+ *
+ * @param[in] pidp      pointer to the @p PidQ31 object
+ *
+ * @api
+ */
+void pidQ31Reset(PidQ31 *pidp)
+{
+  arm_pid_reset_q31(&pidp->pi);
+  pidp->d = 0;
+}
+
+/**
+ * @brief   Q31 controller step.
+ * @note    The @p arm_pid_q31() recurrence is evaluated here with the sum
+ *          saturated, the library version wraps when the integrator is
+ *          close to full scale.
+ *
+ * @param[in] pidp      pointer to the @p PidQ31 object
+ * @param[in] setpoint  desired value
+ * @param[in] measure   measured value
+ * @param[in] ff        feed-forward added to the output
+ * @return              The saturated controller output.
+ *
+ * @api
+ */
+q31_t pidQ31Update(PidQ31 *pidp, q31_t setpoint, q31_t measure, q31_t ff)
+{
+  const PidQ31Config *cfg = pidp->config;
+  arm_pid_instance_q31 *S = &pidp->pi;
+  q31_t e, dk, pi;
+  q63_t acc;
+
+  e = clip_q63_to_q31((q63_t)setpoint - measure);
+
+  /* Filtered derivative of the error.*/
+  dk = clip_q63_to_q31((((q63_t)e - S->state[0]) * cfg->kd) >> 31);
+  pidp->d += (q31_t)((((q63_t)dk - pidp->d) * cfg->d_alpha) >> 31);
+
+  /* Proportional-integral increment, the integrator stays within the
+     output limits.*/
+  acc = (q63_t)S->A0 * e + (q63_t)S->A1 * S->state[0];
+  pi = clamp_q31((acc >> 31) + S->state[2], cfg->out_min, cfg->out_max);
+
+  S->state[1] = S->state[0];
+  S->state[0] = e;
+  S->state[2] = pi;
+
+  return clamp_q31((q63_t)pi + pidp->d + ff, cfg->out_min, cfg->out_max);
+}
+
+/**
+ * @brief   Initializes a Q15 controller.
+ *
+ * @param[out] pidp     pointer to the @p PidQ15 object
+ * @param[in] config    pointer to the controller configuration
+ *
+ * @api
+ */
+void pidQ15Init(PidQ15 *pidp, const PidQ15Config *config)
+{
+  chDbgCheck(config->out_min < config->out_max);
+
+  pidp->config = config;
+  pidp->pi.Kp = config->kp;
+  pidp->pi.Ki = config->ki;
+  pidp->pi.Kd = 0;
+  arm_pid_init_q15(&pidp->pi, 1);
+  pidp->d = 0;
+}
+
+/**
+ * @brief   Clears the state of a Q15 controller.
+ *
+ * @param[in] pidp      pointer to the @p PidQ15 object
+ *
+ * @api
+ */
+void pidQ15Reset(PidQ15 *pidp)
+{
+  arm_pid_reset_q15(&pidp->pi);
+  pidp->d = 0;
+}
+
+/**
+ * @brief   Q15 controller step.
+ *
+ * @param[in] pidp      pointer to the @p PidQ15 object
+ * @param[in] setpoint  desired value
+ * @param[in] measure   measured value
+ * @param[in] ff        feed-forward added to the output
+ * @return              The saturated controller output.
+ *
+ * @api
+ */
+q15_t pidQ15Update(PidQ15 *pidp, q15_t setpoint, q15_t measure, q15_t ff)
+{
+  const PidQ15Config *cfg = pidp->config;
+  arm_pid_instance_q15 *S = &pidp->pi;
+  q15_t e, dk, pi;
+
+  e = (q15_t)__SSAT((q31_t)setpoint - measure, 16);
+
+  /* Filtered derivative of the error.*/
+  dk = (q15_t)__SSAT((((q31_t)e - S->state[0]) * cfg->kd) >> 15, 16);
+  pidp->d += (q15_t)((((q31_t)dk - pidp->d) * cfg->d_alpha) >> 15);
+
+  /* The library step saturates, only the output limits are enforced on
+     the integrator.*/
+  pi = clamp_q15(arm_pid_q15(S, e), cfg->out_min, cfg->out_max);
+  S->state[2] = pi;
+
+  return clamp_q15((q31_t)pi + pidp->d + ff, cfg->out_min, cfg->out_max);
+}
+
+/**
+ * @brief   Initializes a Q31 cascade controller.
+ *
+ * @param[out] cpp      pointer to the @p CascadePidQ31 object
+ * @param[in] outer     pointer to the outer loop configuration
+ * @param[in] inner     pointer to the inner loop configuration
+ * @param[in] div       inner loop updates per outer loop update
+ *
+ * @api
+ */
+void cascadePidQ31Init(CascadePidQ31 *cpp, const PidQ31Config *outer,
+                       const PidQ31Config *inner, unsigned div)
+{
+  chDbgCheck(div > 0);
+
+  pidQ31Init(&cpp->outer, outer);
+  pidQ31Init(&cpp->inner, inner);
+  cpp->div = div;
+  cpp->cnt = 0;
+  cpp->ref = 0;
+}
+
+/**
+ * @brief   Clears the state of a Q31 cascade controller.
+ *
+ * @param[in] cpp       pointer to the @p CascadePidQ31 object
+ *
+ * @api
+ */
+void cascadePidQ31Reset(CascadePidQ31 *cpp)
+{
+  pidQ31Reset(&cpp->outer);
+  pidQ31Reset(&cpp->inner);
+  cpp->cnt = 0;
+  cpp->ref = 0;
+}
+
+/**
+ * @brief   Q31 cascade controller step, at the inner loop rate.
+ *
+ * @param[in] cpp           pointer to the @p CascadePidQ31 object
+ * @param[in] setpoint      outer loop desired value
+ * @param[in] outer_measure outer loop measured value
+ * @param[in] inner_measure inner loop measured value
+ * @param[in] ff            feed-forward added to the inner loop output
+ * @return                  The saturated inner loop output.
+ *
+ * @api
+ */
+q31_t cascadePidQ31Update(CascadePidQ31 *cpp, q31_t setpoint,
+                          q31_t outer_measure, q31_t inner_measure, q31_t ff)
+{
+  if (cpp->cnt == 0)
+  {
+    cpp->ref = pidQ31Update(&cpp->outer, setpoint, outer_measure, 0);
+    cpp->cnt = cpp->div;
+  }
+  cpp->cnt--;
+
+  return pidQ31Update(&cpp->inner, cpp->ref, inner_measure, ff);
+}
+
+/**
+ * @brief   Initializes a Q15 cascade controller.
+ *
+ * @param[out] cpp      pointer to the @p CascadePidQ15 object
+ * @param[in] outer     pointer to the outer loop configuration
+ * @param[in] inner     pointer to the inner loop configuration
+ * @param[in] div       inner loop updates per outer loop update
+ *
+ * @api
+ */
+void cascadePidQ15Init(CascadePidQ15 *cpp, const PidQ15Config *outer,
+                       const PidQ15Config *inner, unsigned div)
+{
+  chDbgCheck(div > 0);
+
+  pidQ15Init(&cpp->outer, outer);
+  pidQ15Init(&cpp->inner, inner);
+  cpp->div = div;
+  cpp->cnt = 0;
+  cpp->ref = 0;
+}
+
+/**
+ * @brief   Clears the state of a Q15 cascade controller.
+ *
+ * @param[in] cpp       pointer to the @p CascadePidQ15 object
+ *
+ * @api
+ */
+void cascadePidQ15Reset(CascadePidQ15 *cpp)
+{
+  pidQ15Reset(&cpp->outer);
+  pidQ15Reset(&cpp->inner);
+  cpp->cnt = 0;
+  cpp->ref = 0;
+}
+
+/**
+ * @brief   Q15 cascade controller step, at the inner loop rate.
+ *
+ * @param[in] cpp           pointer to the @p CascadePidQ15 object
+ * @param[in] setpoint      outer loop desired value
+ * @param[in] outer_measure outer loop measured value
+ * @param[in] inner_measure inner loop measured value
+ * @param[in] ff            feed-forward added to the inner loop output
+ * @return                  The saturated inner loop output.
+ *
+ * @api
+ */
+q15_t cascadePidQ15Update(CascadePidQ15 *cpp, q15_t setpoint,
+                          q15_t outer_measure, q15_t inner_measure, q15_t ff)
+{
+  if (cpp->cnt == 0)
+  {
+    cpp->ref = pidQ15Update(&cpp->outer, setpoint, outer_measure, 0);
+    cpp->cnt = cpp->div;
+  }
+  cpp->cnt--;
+
+  return pidQ15Update(&cpp->inner, cpp->ref, inner_measure, ff);
+}
+
+/** @} */
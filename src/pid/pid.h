@@ -0,0 +1,170 @@
+/**
+ * @file    pid.h
+ * @brief   Fixed-point PID and cascade PID controllers.
+ *
+ * @addtogroup PID
+ * @{
+ */
+
+#ifndef PID_H
+#define PID_H
+
+#include "ch.h"
+#include "arm_math.h"
+
+/*===========================================================================*/
+/* Module constants.                                                         */
+/*===========================================================================*/
+
+/*===========================================================================*/
+/* Module pre-compile time settings.                                         */
+/*===========================================================================*/
+
+/*===========================================================================*/
+/* Derived constants and error checks.                                       */
+/*===========================================================================*/
+
+/*===========================================================================*/
+/* Module data structures and types.                                         */
+/*===========================================================================*/
+
+/**
+ * @brief   Q31 controller configuration.
+ * @note    Gains are per sample, @p ki is Ki * Ts and @p kd is Kd / Ts, all
+ *          of them in the [0, 1) range of the signals full scale.
+ */
+typedef struct
+{
+  q31_t kp;      /**< @brief Proportional gain.                          */
+  q31_t ki;      /**< @brief Integral gain.                              */
+  q31_t kd;      /**< @brief Derivative gain.                            */
+  q31_t d_alpha; /**< @brief Derivative low-pass coefficient,
+                             Ts / (Tf + Ts), @p PID_Q31(1.0) disables
+                             the filter.                               */
+  q31_t out_min; /**< @brief Lower output limit.                         */
+  q31_t out_max; /**< @brief Upper output limit.                         */
+} PidQ31Config;
+
+/**
+ * @brief   Q31 controller object.
+ */
+typedef struct
+{
+  arm_pid_instance_q31 pi;     /**< @brief Proportional-integral part. */
+  const PidQ31Config *config;  /**< @brief Controller configuration.   */
+  q31_t d;                     /**< @brief Filtered derivative term.   */
+} PidQ31;
+
+/**
+ * @brief   Q15 controller configuration.
+ * @note    Same meaning as @p PidQ31Config, with Q15 values.
+ */
+typedef struct
+{
+  q15_t kp;      /**< @brief Proportional gain.                          */
+  q15_t ki;      /**< @brief Integral gain.                              */
+  q15_t kd;      /**< @brief Derivative gain.                            */
+  q15_t d_alpha; /**< @brief Derivative low-pass coefficient.            */
+  q15_t out_min; /**< @brief Lower output limit.                         */
+  q15_t out_max; /**< @brief Upper output limit.                         */
+} PidQ15Config;
+
+/**
+ * @brief   Q15 controller object.
+ */
+typedef struct
+{
+  arm_pid_instance_q15 pi;     /**< @brief Proportional-integral part. */
+  const PidQ15Config *config;  /**< @brief Controller configuration.   */
+  q15_t d;                     /**< @brief Filtered derivative term.   */
+} PidQ15;
+
+/**
+ * @brief   Q31 cascade controller object.
+ * @details The outer loop output is the inner loop setpoint, the outer
+ *          loop runs once every @p div inner loop updates.
+ */
+typedef struct
+{
+  PidQ31 outer;   /**< @brief Outer loop, e.g. speed.                    */
+  PidQ31 inner;   /**< @brief Inner loop, e.g. current.                  */
+  unsigned div;   /**< @brief Inner updates per outer update.            */
+  unsigned cnt;   /**< @brief Inner updates until the next outer one.    */
+  q31_t ref;      /**< @brief Current inner loop setpoint.               */
+} CascadePidQ31;
+
+/**
+ * @brief   Q15 cascade controller object.
+ */
+typedef struct
+{
+  PidQ15 outer;   /**< @brief Outer loop, e.g. speed.                    */
+  PidQ15 inner;   /**< @brief Inner loop, e.g. current.                  */
+  unsigned div;   /**< @brief Inner updates per outer update.            */
+  unsigned cnt;   /**< @brief Inner updates until the next outer one.    */
+  q15_t ref;      /**< @brief Current inner loop setpoint.               */
+} CascadePidQ15;
+
+/*===========================================================================*/
+/* Module macros.                                                            */
+/*===========================================================================*/
+
+/**
+ * @brief   Constant to Q31, saturated.
+ * @note    Meant for constant expressions only, it is folded at compile
+ *          time and does not pull in the floating point library.
+ *
+ * @param[in] x         value in the [-1, 1] range
+ */
+#define PID_Q31(x)                                                       \
+  ((x) >= 1.0 ? (q31_t)0x7FFFFFFF                                        \
+              : ((x) <= -1.0 ? (q31_t)0x80000000                         \
+                             : (q31_t)((x) * 2147483648.0)))
+
+/**
+ * @brief   Constant to Q15, saturated.
+ * @note    Meant for constant expressions only.
+ *
+ * @param[in] x         value in the [-1, 1] range
+ */
+#define PID_Q15(x)                                                       \
+  ((x) >= 1.0 ? (q15_t)0x7FFF                                            \
+              : ((x) <= -1.0 ? (q15_t)0x8000 : (q15_t)((x) * 32768.0)))
+
+/*===========================================================================*/
+/* External declarations.                                                    */
+/*===========================================================================*/
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+  void pidQ31Init(PidQ31 *pidp, const PidQ31Config *config);
+  void pidQ31Reset(PidQ31 *pidp);
+  q31_t pidQ31Update(PidQ31 *pidp, q31_t setpoint, q31_t measure, q31_t ff);
+  void pidQ15Init(PidQ15 *pidp, const PidQ15Config *config);
+  void pidQ15Reset(PidQ15 *pidp);
+  q15_t pidQ15Update(PidQ15 *pidp, q15_t setpoint, q15_t measure, q15_t ff);
+  void cascadePidQ31Init(CascadePidQ31 *cpp, const PidQ31Config *outer,
+                         const PidQ31Config *inner, unsigned div);
+  void cascadePidQ31Reset(CascadePidQ31 *cpp);
+  q31_t cascadePidQ31Update(CascadePidQ31 *cpp, q31_t setpoint,
+                            q31_t outer_measure, q31_t inner_measure,
+                            q31_t ff);
+  void cascadePidQ15Init(CascadePidQ15 *cpp, const PidQ15Config *outer,
+                         const PidQ15Config *inner, unsigned div);
+  void cascadePidQ15Reset(CascadePidQ15 *cpp);
+  q15_t cascadePidQ15Update(CascadePidQ15 *cpp, q15_t setpoint,
+                            q15_t outer_measure, q15_t inner_measure,
+                            q15_t ff);
+#ifdef __cplusplus
+}
+#endif
+
+/*===========================================================================*/
+/* Module inline functions.                                                  */
+/*===========================================================================*/
+
+#endif /* PID_H */
+
+/** @} */
@@ -0,0 +1,8 @@
+# Fixed-point PID files.
+PIDSRC = $(COREDIR)/src/pid/pid.c
+
+PIDINC = $(COREDIR)/src/pid
+
+# Shared variables
+ALLCSRC += $(PIDSRC)
+ALLINC  += $(PIDINC)
@@ -54,6 +54,11 @@ bool shell_initialized = false;
 /* Module local variables.                                                   */
 /*===========================================================================*/
 
+/**
+ * @brief   Registered commands table, from the linker script.
+ */
+extern const ShellCommand __shellcmd_base__[], __shellcmd_end__[];
+
 /*===========================================================================*/
 /* Module local functions.                                                   */
 /*===========================================================================*/
@@ -106,6 +111,23 @@ static void list_commands(BaseSequentialStream *chp, const ShellCommand *scp)
   }
 }
 
+static void list_registered(BaseSequentialStream *chp)
+{
+  const ShellCommand *scp;
+
+  for (scp = __shellcmd_base__; scp < __shellcmd_end__; scp++)
+    chprintf(chp, "%s ", scp->sc_name);
+}
+
+static void cmdrun(const ShellCommand *scp, BaseSequentialStream *chp,
+                   int argc, char *argv[])
+{
+
+  chMtxLock(&shell_cmd_mutex);
+  scp->sc_function(chp, argc, argv);
+  chMtxUnlock(&shell_cmd_mutex);
+}
+
 static bool cmdexec(const ShellCommand *scp, BaseSequentialStream *chp,
                     char *name, int argc, char *argv[])
 {
@@ -114,9 +136,7 @@ static bool cmdexec(const ShellCommand *scp, BaseSequentialStream *chp,
   {
     if (strcmp(scp->sc_name, name) == 0)
     {
-      chMtxLock(&shell_cmd_mutex);
-      scp->sc_function(chp, argc, argv);
-      chMtxUnlock(&shell_cmd_mutex);
+      cmdrun(scp, chp, argc, argv);
       return false;
     }
     scp++;
@@ -124,6 +144,35 @@ static bool cmdexec(const ShellCommand *scp, BaseSequentialStream *chp,
   return true;
 }
 
+/**
+ * @brief   Runs a registered command.
+ * @details The table is sorted by name, binary search.
+ *
+ * @return              The command was not found.
+ */
+static bool cmdexec_registered(BaseSequentialStream *chp, char *name,
+                               int argc, char *argv[])
+{
+  const ShellCommand *lo = __shellcmd_base__, *hi = __shellcmd_end__;
+
+  while (lo < hi)
+  {
+    const ShellCommand *mid = lo + (hi - lo) / 2;
+    int c = strcmp(mid->sc_name, name);
+
+    if (c == 0)
+    {
+      cmdrun(mid, chp, argc, argv);
+      return false;
+    }
+    if (c < 0)
+      lo = mid + 1;
+    else
+      hi = mid;
+  }
+  return true;
+}
+
 #if (SHELL_USE_HISTORY == TRUE) || defined(__DOXYGEN__)
 static void del_histbuff_entry(ShellHistory *shp)
 {
@@ -266,7 +315,7 @@ static int get_history(ShellHistory *shp, char *line, int dir)
 #if (SHELL_USE_COMPLETION == TRUE) || defined(__DOXYGEN__)
 static void get_completions(ShellConfig *scfg, char *line)
 {
-  const ShellCommand *lcp = shell_local_commands;
+  const ShellCommand *lcp = __shellcmd_base__;
   const ShellCommand *scp = scfg->sc_commands;
   char **scmp = scfg->sc_completion;
   char help_cmp[] = "help";
@@ -275,7 +324,7 @@ static void get_completions(ShellConfig *scfg, char *line)
   {
     *scmp++ = help_cmp;
   }
-  while (lcp->sc_name != NULL)
+  while (lcp < __shellcmd_end__)
   {
     if (strstr(lcp->sc_name, line) == lcp->sc_name)
     {
@@ -442,12 +491,12 @@ THD_FUNCTION(shellThread, p)
           continue;
         }
         chprintf(chp, "Commands: help ");
-        list_commands(chp, shell_local_commands);
+        list_registered(chp);
         if (scp != NULL)
           list_commands(chp, scp);
         chprintf(chp, SHELL_NEWLINE_STR);
       }
-      else if (cmdexec(shell_local_commands, chp, cmd, n, args) &&
+      else if (cmdexec_registered(chp, cmd, n, args) &&
                ((scp == NULL) || cmdexec(scp, chp, cmd, n, args)))
       {
         chprintf(chp, "%s", cmd);
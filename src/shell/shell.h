@@ -194,6 +194,21 @@ typedef struct
  */
 #define _shell_clr_line(stream) chprintf(stream, "\033[K")
 
+/**
+ * @brief   Registers a shell command.
+ * @details The entry goes into its own input section, the linker gathers
+ *          all of them into a flash table sorted by name. Names must be
+ *          unique and valid C identifiers.
+ *
+ * @param[in] name      command name, unquoted
+ * @param[in] func      command function
+ *
+ * @api
+ */
+#define SHELL_COMMAND(name, func)                                           \
+  static const ShellCommand shell_command_##name                            \
+      __attribute__((used, section(".shellcmd." #name))) = {#name, (func)}
+
 /**
  * @brief   Prints out usage message
  *
@@ -30,6 +30,14 @@
 #include "shell_cmd.h"
 #include "chprintf.h"
 
+#if (SHELL_CMD_LATENCY_ENABLED == TRUE) || defined(__DOXYGEN__)
+#include "latency.h"
+#endif
+
+#if (SHELL_CMD_OBJECTS_ENABLED == TRUE) || defined(__DOXYGEN__)
+#include "objreg.h"
+#endif
+
 #if (SHELL_CMD_TEST_ENABLED == TRUE) || defined(__DOXYGEN__)
 #include "rt_test_root.h"
 #include "oslib_test_root.h"
@@ -69,6 +77,8 @@ static void cmd_exit(BaseSequentialStream *chp, int argc, char *argv[])
 
   shellExit(MSG_OK);
 }
+
+SHELL_COMMAND(exit, cmd_exit);
 #endif
 
 #if (SHELL_CMD_INFO_ENABLED == TRUE) || defined(__DOXYGEN__)
@@ -105,6 +115,8 @@ static void cmd_info(BaseSequentialStream *chp, int argc, char *argv[])
 #endif
 #endif
 }
+
+SHELL_COMMAND(info, cmd_info);
 #endif
 
 #if (SHELL_CMD_ECHO_ENABLED == TRUE) || defined(__DOXYGEN__)
@@ -119,6 +131,8 @@ static void cmd_echo(BaseSequentialStream *chp, int argc, char *argv[])
   }
   chprintf(chp, "%s" SHELL_NEWLINE_STR, argv[0]);
 }
+
+SHELL_COMMAND(echo, cmd_echo);
 #endif
 
 #if (SHELL_CMD_SYSTIME_ENABLED == TRUE) || defined(__DOXYGEN__)
@@ -133,6 +147,8 @@ static void cmd_systime(BaseSequentialStream *chp, int argc, char *argv[])
   }
   chprintf(chp, "%lu" SHELL_NEWLINE_STR, (unsigned long)chVTGetSystemTime());
 }
+
+SHELL_COMMAND(systime, cmd_systime);
 #endif
 
 #if (SHELL_CMD_MEM_ENABLED == TRUE) || defined(__DOXYGEN__)
@@ -152,6 +168,8 @@ static void cmd_mem(BaseSequentialStream *chp, int argc, char *argv[])
   chprintf(chp, "heap free total  : %u bytes" SHELL_NEWLINE_STR, total);
   chprintf(chp, "heap free largest: %u bytes" SHELL_NEWLINE_STR, largest);
 }
+
+SHELL_COMMAND(mem, cmd_mem);
 #endif
 
 #if (SHELL_CMD_THREADS_ENABLED == TRUE) || defined(__DOXYGEN__)
@@ -182,6 +200,43 @@ static void cmd_threads(BaseSequentialStream *chp, int argc, char *argv[])
     tp = chRegNextThread(tp);
   } while (tp != NULL);
 }
+
+SHELL_COMMAND(threads, cmd_threads);
+#endif
+
+#if (SHELL_CMD_LATENCY_ENABLED == TRUE) || defined(__DOXYGEN__)
+static void cmd_latency(BaseSequentialStream *chp, int argc, char *argv[])
+{
+  bool reset = false;
+
+  if (argc == 1 && !strcmp(argv[0], "reset"))
+  {
+    reset = true;
+  }
+  else if (argc > 0)
+  {
+    shellUsage(chp, "latency [reset]");
+    return;
+  }
+  latencyPrint(chp, reset);
+}
+
+SHELL_COMMAND(latency, cmd_latency);
+#endif
+
+#if (SHELL_CMD_OBJECTS_ENABLED == TRUE) || defined(__DOXYGEN__)
+static void cmd_objects(BaseSequentialStream *chp, int argc, char *argv[])
+{
+
+  if (argc > 1)
+  {
+    shellUsage(chp, "objects [name]");
+    return;
+  }
+  objregPrint(chp, argc == 1 ? argv[0] : NULL);
+}
+
+SHELL_COMMAND(objects, cmd_objects);
 #endif
 
 #if (SHELL_CMD_TEST_ENABLED == TRUE) || defined(__DOXYGEN__)
@@ -231,37 +286,12 @@ static void cmd_test(BaseSequentialStream *chp, int argc, char *argv[])
   }
   chThdWait(tp);
 }
+
+SHELL_COMMAND(test, cmd_test);
 #endif
 
 /*===========================================================================*/
 /* Module exported functions.                                                */
 /*===========================================================================*/
 
-/**
- * @brief   Array of the default commands.
- */
-const ShellCommand shell_local_commands[] = {
-#if (SHELL_CMD_EXIT_ENABLED == TRUE) && !defined(_CHIBIOS_NIL_)
-    {"exit", cmd_exit},
-#endif
-#if SHELL_CMD_INFO_ENABLED == TRUE
-    {"info", cmd_info},
-#endif
-#if SHELL_CMD_ECHO_ENABLED == TRUE
-    {"echo", cmd_echo},
-#endif
-#if SHELL_CMD_SYSTIME_ENABLED == TRUE
-    {"systime", cmd_systime},
-#endif
-#if SHELL_CMD_MEM_ENABLED == TRUE
-    {"mem", cmd_mem},
-#endif
-#if SHELL_CMD_THREADS_ENABLED == TRUE
-    {"threads", cmd_threads},
-#endif
-#if SHELL_CMD_TEST_ENABLED == TRUE
-    {"test", cmd_test},
-#endif
-    {NULL, NULL}};
-
 /** @} */
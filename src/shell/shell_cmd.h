@@ -58,6 +58,14 @@
 #define SHELL_CMD_THREADS_ENABLED           TRUE
 #endif
 
+#if !defined(SHELL_CMD_LATENCY_ENABLED) || defined(__DOXYGEN__)
+#define SHELL_CMD_LATENCY_ENABLED           TRUE
+#endif
+
+#if !defined(SHELL_CMD_OBJECTS_ENABLED) || defined(__DOXYGEN__)
+#define SHELL_CMD_OBJECTS_ENABLED           TRUE
+#endif
+
 #if !defined(SHELL_CMD_TEST_ENABLED) || defined(__DOXYGEN__)
 #define SHELL_CMD_TEST_ENABLED              TRUE
 #endif
@@ -82,6 +90,10 @@
 #error "SHELL_CMD_THREADS_ENABLED requires CH_CFG_USE_REGISTRY"
 #endif
 
+#if (SHELL_CMD_LATENCY_ENABLED == TRUE) && (CH_CFG_USE_TM == FALSE)
+#error "SHELL_CMD_LATENCY_ENABLED requires CH_CFG_USE_TM"
+#endif
+
 /*===========================================================================*/
 /* Module data structures and types.                                         */
 /*===========================================================================*/
@@ -94,10 +106,6 @@
 /* External declarations.                                                    */
 /*===========================================================================*/
 
-#if !defined(__DOXYGEN__)
-extern const ShellCommand shell_local_commands[];
-#endif
-
 #ifdef __cplusplus
 extern "C" {
 #endif
@@ -0,0 +1,326 @@
+/**
+ * @file    speed_sensor.c
+ * @brief   Batched input capture and quadrature encoder readers.
+ * @details Capture channels run the ICU timer in PWM input mode, every
+ *          active edge triggers a DMA burst that copies the period and width
+ *          capture registers into a circular buffer. Period and duty are
+ *          averaged and filtered once per batch of edges from the DMA
+ *          interrupt, the only per-edge work is done by the DMA itself.
+ *          Encoders use the timer encoder interface, the 16 bits counter is
+ *          extended to 32 bits on every read.
+ *
+ * @addtogroup SPEED_SENSOR
+ * @{
+ */
+
+#include "ch.h"
+#include "hal.h"
+#include "speed_sensor.h"
+
+/*===========================================================================*/
+/* Module local definitions.                                                 */
+/*===========================================================================*/
+
+/**
+ * @brief   Offset of CCR1 in the timer registers block, in words.
+ */
+#define TIM_DBA_CCR1 13U
+
+/*===========================================================================*/
+/* Module exported variables.                                                */
+/*===========================================================================*/
+
+/*===========================================================================*/
+/* Module local types.                                                       */
+/*===========================================================================*/
+
+/*===========================================================================*/
+/* Module local variables.                                                   */
+/*===========================================================================*/
+
+/*===========================================================================*/
+/* Module local functions.                                                   */
+/*===========================================================================*/
+
+#if (HAL_USE_ICU == TRUE) || defined(__DOXYGEN__)
+/**
+ * @brief   Timer overflow, no edge for a whole timer period.
+ */
+static void speed_sensor_overflow_cb(ICUDriver *icup)
+{
+  SpeedSensor *ssp = (SpeedSensor *)icup->config;
+
+  ssp->period = 0;
+  ssp->duty = 0;
+
+  /* The first period after a stall is not meaningful.*/
+  ssp->skip = true;
+}
+
+/**
+ * @brief   Capture DMA half/full transfer interrupt.
+ */
+static void speed_sensor_dma_cb(SpeedSensor *ssp, uint32_t flags)
+{
+  const uint16_t(*p)[2];
+  uint32_t periods = 0, widths = 0, avg, duty;
+  unsigned i;
+
+  if ((flags & STM32_DMA_ISR_TEIF) != 0)
+  {
+    ssp->skip = true;
+    return;
+  }
+
+  if ((flags & STM32_DMA_ISR_TCIF) != 0)
+    p = &ssp->buf[SPEED_SENSOR_BATCH_SIZE];
+  else
+    p = &ssp->buf[0];
+
+  for (i = 0; i < SPEED_SENSOR_BATCH_SIZE; i++)
+  {
+    periods += p[i][0] + 1U;
+    widths += p[i][1] + 1U;
+  }
+
+  if (ssp->skip)
+  {
+    ssp->skip = false;
+    return;
+  }
+
+  avg = (periods << 8) / SPEED_SENSOR_BATCH_SIZE;
+  duty = (uint32_t)(((uint64_t)widths << 16) / periods);
+  if (ssp->period == 0)
+  {
+    ssp->period = avg;
+    ssp->duty = duty;
+  }
+  else
+  {
+    ssp->period += ((int32_t)(avg - ssp->period)) >> SPEED_SENSOR_FILTER_SHIFT;
+    ssp->duty += ((int32_t)(duty - ssp->duty)) >> SPEED_SENSOR_FILTER_SHIFT;
+  }
+}
+#endif /* HAL_USE_ICU == TRUE */
+
+/*===========================================================================*/
+/* Module exported functions.                                                */
+/*===========================================================================*/
+
+#if (HAL_USE_ICU == TRUE) || defined(__DOXYGEN__)
+/**
+ * @brief   Starts a capture channel on TIMx channel 1.
+ * @note    The timer and DMA interrupts must have the same priority, see
+ *          @p SPEED_SENSOR_DMA_IRQ_PRIORITY.
+ *
+ * @param[out] ssp      pointer to the @p SpeedSensor object
+ * @param[in] icup      pointer to a stopped @p ICUDriver object
+ * @param[in] config    pointer to the channel configuration
+ *
+ * @api
+ */
+void speedSensorStart(SpeedSensor *ssp, ICUDriver *icup,
+                      const SpeedSensorConfig *config)
+{
+  ssp->icucfg.mode = config->mode;
+  ssp->icucfg.frequency = config->frequency;
+  ssp->icucfg.width_cb = NULL;
+  ssp->icucfg.period_cb = NULL;
+  ssp->icucfg.overflow_cb = speed_sensor_overflow_cb;
+  ssp->icucfg.channel = ICU_CHANNEL_1;
+  ssp->icucfg.dier = STM32_TIM_DIER_CC1DE;
+  ssp->config = config;
+  ssp->icup = icup;
+  ssp->skip = true;
+  ssp->period = 0;
+  ssp->duty = 0;
+
+  ssp->dmastp = dmaStreamAlloc(config->dmastream,
+                               SPEED_SENSOR_DMA_IRQ_PRIORITY,
+                               (stm32_dmaisr_t)speed_sensor_dma_cb,
+                               (void *)ssp);
+  osalDbgAssert(ssp->dmastp != NULL, "unable to allocate stream");
+
+  icuStart(icup, &ssp->icucfg);
+
+  /* Each CC1 request bursts CCR1 (period) and CCR2 (width).*/
+  icup->tim->DCR = STM32_TIM_DCR_DBL(1) | STM32_TIM_DCR_DBA(TIM_DBA_CCR1);
+  dmaStreamSetPeripheral(ssp->dmastp, &icup->tim->DMAR);
+  dmaStreamSetMemory0(ssp->dmastp, ssp->buf);
+  dmaStreamSetTransactionSize(ssp->dmastp, 2 * SPEED_SENSOR_BATCH_SIZE * 2);
+  dmaStreamSetMode(ssp->dmastp,
+                   STM32_DMA_CR_PL(SPEED_SENSOR_DMA_PRIORITY) |
+                       STM32_DMA_CR_PSIZE_HWORD | STM32_DMA_CR_MSIZE_HWORD |
+                       STM32_DMA_CR_MINC | STM32_DMA_CR_CIRC |
+                       STM32_DMA_CR_HTIE | STM32_DMA_CR_TCIE |
+                       STM32_DMA_CR_TEIE);
+  dmaStreamEnable(ssp->dmastp);
+
+  icuStartCapture(icup);
+
+  /* Only the overflow interrupt is enabled, notifications would also
+     enable the per-edge interrupt.*/
+  osalSysLock();
+  icup->tim->DIER |= STM32_TIM_DIER_UIE;
+  osalSysUnlock();
+}
+
+/**
+ * @brief   Stops a capture channel.
+ *
+ * @param[in] ssp       pointer to the @p SpeedSensor object
+ *
+ * @api
+ */
+void speedSensorStop(SpeedSensor *ssp)
+{
+  icuStopCapture(ssp->icup);
+  icuStop(ssp->icup);
+  dmaStreamDisable(ssp->dmastp);
+  dmaStreamFree(ssp->dmastp);
+  ssp->dmastp = NULL;
+  ssp->period = 0;
+  ssp->duty = 0;
+}
+
+/**
+ * @brief   Filtered input frequency.
+ *
+ * @param[in] ssp       pointer to the @p SpeedSensor object
+ * @return              The frequency in mHz, zero when stalled.
+ *
+ * @api
+ */
+uint32_t speedSensorGetFrequency(SpeedSensor *ssp)
+{
+  uint32_t period = ssp->period;
+
+  if (period == 0)
+    return 0;
+
+  return (uint32_t)(((uint64_t)ssp->config->frequency * 1000U * 256U) /
+                    period);
+}
+
+/**
+ * @brief   Filtered rotation speed.
+ *
+ * @param[in] ssp       pointer to the @p SpeedSensor object
+ * @return              The speed in RPM, zero when stalled.
+ *
+ * @api
+ */
+uint32_t speedSensorGetRPM(SpeedSensor *ssp)
+{
+  uint32_t period = ssp->period;
+
+  if (period == 0)
+    return 0;
+
+  return (uint32_t)(((uint64_t)ssp->config->frequency * 60U * 256U) /
+                    ((uint64_t)period * ssp->config->pulses_per_rev));
+}
+
+/**
+ * @brief   Filtered duty cycle.
+ *
+ * @param[in] ssp       pointer to the @p SpeedSensor object
+ * @return              The duty cycle in Q16, zero when stalled.
+ *
+ * @api
+ */
+uint32_t speedSensorGetDuty(SpeedSensor *ssp)
+{
+  return ssp->duty;
+}
+#endif /* HAL_USE_ICU == TRUE */
+
+/**
+ * @brief   Starts a quadrature encoder on TIMx channels 1 and 2.
+ * @note    The timer must not be used by any other driver.
+ *
+ * @param[out] qep      pointer to the @p QuadEncoder object
+ * @param[in] tim       pointer to the timer registers block
+ * @param[in] filter    input filter, @p ICxF field value
+ *
+ * @api
+ */
+void encoderStart(QuadEncoder *qep, stm32_tim_t *tim, uint32_t filter)
+{
+  if (tim == STM32_TIM1)
+  {
+    rccEnableTIM1(true);
+  }
+  else if (tim == STM32_TIM2)
+  {
+    rccEnableTIM2(true);
+  }
+  else if (tim == STM32_TIM3)
+  {
+    rccEnableTIM3(true);
+  }
+  else if (tim == STM32_TIM4)
+  {
+    rccEnableTIM4(true);
+  }
+  else
+  {
+    osalDbgAssert(false, "invalid timer");
+  }
+
+  /* Both inputs mapped on their own pin, counting on both edges of both
+     inputs (SMS = 011).*/
+  tim->CR1 = 0;
+  tim->SMCR = STM32_TIM_SMCR_SMS(3);
+  tim->CCMR1 = STM32_TIM_CCMR1_CC1S(1) | STM32_TIM_CCMR1_IC1F(filter) |
+               STM32_TIM_CCMR1_CC2S(1) | STM32_TIM_CCMR1_IC2F(filter);
+  tim->CCER = 0;
+  tim->ARR = 0xFFFF;
+  tim->CNT = 0;
+  tim->CR1 = STM32_TIM_CR1_CEN;
+
+  qep->tim = tim;
+  qep->last = 0;
+  qep->count = 0;
+}
+
+/**
+ * @brief   Stops a quadrature encoder.
+ *
+ * @param[in] qep       pointer to the @p QuadEncoder object
+ *
+ * @api
+ */
+void encoderStop(QuadEncoder *qep)
+{
+  qep->tim->CR1 = 0;
+  qep->tim->SMCR = 0;
+}
+
+/**
+ * @brief   Overflow-extended encoder position.
+ * @note    The counter is extended on read, it must be read at least once
+ *          every 32768 counts.
+ *
+ * @param[in] qep       pointer to the @p QuadEncoder object
+ * @return              The position in counts since @p encoderStart().
+ *
+ * @api
+ */
+int32_t encoderGetCount(QuadEncoder *qep)
+{
+  uint16_t cnt;
+  int32_t count;
+
+  chSysLock();
+  cnt = (uint16_t)qep->tim->CNT;
+  qep->count += (int16_t)(cnt - qep->last);
+  qep->last = cnt;
+  count = qep->count;
+  chSysUnlock();
+
+  return count;
+}
+
+/** @} */
@@ -0,0 +1,148 @@
+/**
+ * @file    speed_sensor.h
+ * @brief   Batched input capture and quadrature encoder readers.
+ *
+ * @addtogroup SPEED_SENSOR
+ * @{
+ */
+
+#ifndef SPEED_SENSOR_H
+#define SPEED_SENSOR_H
+
+#include "ch.h"
+#include "hal.h"
+
+/*===========================================================================*/
+/* Module constants.                                                         */
+/*===========================================================================*/
+
+/*===========================================================================*/
+/* Module pre-compile time settings.                                         */
+/*===========================================================================*/
+
+/**
+ * @brief   Captured edges per batch.
+ * @details The DMA buffer holds two batches, period and duty are computed
+ *          once per batch from the DMA half/full transfer interrupt.
+ */
+#if !defined(SPEED_SENSOR_BATCH_SIZE) || defined(__DOXYGEN__)
+#define SPEED_SENSOR_BATCH_SIZE 16
+#endif
+
+/**
+ * @brief   Period filter strength.
+ * @details First order low-pass on the batch average, each batch moves the
+ *          filtered period by 1/2^n of the error.
+ */
+#if !defined(SPEED_SENSOR_FILTER_SHIFT) || defined(__DOXYGEN__)
+#define SPEED_SENSOR_FILTER_SHIFT 2
+#endif
+
+/**
+ * @brief   Capture DMA priority.
+ */
+#if !defined(SPEED_SENSOR_DMA_PRIORITY) || defined(__DOXYGEN__)
+#define SPEED_SENSOR_DMA_PRIORITY 1
+#endif
+
+/**
+ * @brief   Capture DMA interrupt priority.
+ */
+#if !defined(SPEED_SENSOR_DMA_IRQ_PRIORITY) || defined(__DOXYGEN__)
+#define SPEED_SENSOR_DMA_IRQ_PRIORITY 7
+#endif
+
+/*===========================================================================*/
+/* Derived constants and error checks.                                       */
+/*===========================================================================*/
+
+/* The batch sum of 16 bit periods is averaged with 8 fractional bits in
+   32 bits.*/
+#if (SPEED_SENSOR_BATCH_SIZE < 1) || (SPEED_SENSOR_BATCH_SIZE > 255)
+#error "SPEED_SENSOR_BATCH_SIZE must be within 1 and 255"
+#endif
+
+/*===========================================================================*/
+/* Module data structures and types.                                         */
+/*===========================================================================*/
+
+#if (HAL_USE_ICU == TRUE) || defined(__DOXYGEN__)
+/**
+ * @brief   Capture channel configuration.
+ */
+typedef struct
+{
+  icufreq_t frequency;     /**< @brief Capture timer clock in Hz.     */
+  icumode_t mode;          /**< @brief Active edge of the input.      */
+  uint32_t dmastream;      /**< @brief DMA stream serving the CC1
+                                       request of the timer, e.g.
+                                       STM32_DMA_STREAM_ID(1, 6) for
+                                       TIM3.                          */
+  uint32_t pulses_per_rev; /**< @brief Input edges per revolution.    */
+} SpeedSensorConfig;
+
+/**
+ * @brief   Capture channel object.
+ * @note    @p icucfg must stay the first field, the ICU callbacks get back
+ *          to the object through the driver configuration pointer.
+ */
+typedef struct
+{
+  ICUConfig icucfg;                  /**< @brief Driver configuration.   */
+  const SpeedSensorConfig *config;   /**< @brief Channel configuration.  */
+  ICUDriver *icup;                   /**< @brief Capture driver.         */
+  const stm32_dma_stream_t *dmastp;  /**< @brief Capture DMA stream.     */
+  bool skip;                         /**< @brief Discard the next batch. */
+  volatile uint32_t period;          /**< @brief Filtered period, ticks
+                                                 in Q24.8, zero when
+                                                 stalled.                */
+  volatile uint32_t duty;            /**< @brief Filtered duty, Q16.     */
+  uint16_t buf[2 * SPEED_SENSOR_BATCH_SIZE][2]; /**< @brief Period and
+                                                           width pairs.  */
+} SpeedSensor;
+#endif /* HAL_USE_ICU == TRUE */
+
+/**
+ * @brief   Quadrature encoder object.
+ */
+typedef struct
+{
+  stm32_tim_t *tim; /**< @brief Timer in encoder mode.            */
+  uint16_t last;    /**< @brief Counter at the previous update.   */
+  int32_t count;    /**< @brief Overflow-extended position.       */
+} QuadEncoder;
+
+/*===========================================================================*/
+/* Module macros.                                                            */
+/*===========================================================================*/
+
+/*===========================================================================*/
+/* External declarations.                                                    */
+/*===========================================================================*/
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+#if (HAL_USE_ICU == TRUE) || defined(__DOXYGEN__)
+  void speedSensorStart(SpeedSensor *ssp, ICUDriver *icup,
+                        const SpeedSensorConfig *config);
+  void speedSensorStop(SpeedSensor *ssp);
+  uint32_t speedSensorGetFrequency(SpeedSensor *ssp);
+  uint32_t speedSensorGetRPM(SpeedSensor *ssp);
+  uint32_t speedSensorGetDuty(SpeedSensor *ssp);
+#endif
+  void encoderStart(QuadEncoder *qep, stm32_tim_t *tim, uint32_t filter);
+  void encoderStop(QuadEncoder *qep);
+  int32_t encoderGetCount(QuadEncoder *qep);
+#ifdef __cplusplus
+}
+#endif
+
+/*===========================================================================*/
+/* Module inline functions.                                                  */
+/*===========================================================================*/
+
+#endif /* SPEED_SENSOR_H */
+
+/** @} */
@@ -0,0 +1,8 @@
+# Input capture and encoder files.
+SPEEDSENSORSRC = $(COREDIR)/src/speed_sensor/speed_sensor.c
+
+SPEEDSENSORINC = $(COREDIR)/src/speed_sensor
+
+# Shared variables
+ALLCSRC += $(SPEEDSENSORSRC)
+ALLINC  += $(SPEEDSENSORINC)
@@ -0,0 +1,198 @@
+/**
+ * @file    timestamp.c
+ * @brief   High resolution timestamp service.
+ * @details The DWT cycle counter is extended to 64 bits, every reader
+ *          accounts for a wrap and a virtual timer guarantees that a wrap
+ *          is never missed. Interrupt handlers record the time of their
+ *          entry into per-source slots, readers translate the stamps to
+ *          microseconds or to system time.
+ *
+ * @addtogroup TIMESTAMP
+ * @{
+ */
+
+#include "ch.h"
+#include "hal.h"
+#include "timestamp.h"
+
+/*===========================================================================*/
+/* Module local definitions.                                                 */
+/*===========================================================================*/
+
+/*===========================================================================*/
+/* Module exported variables.                                                */
+/*===========================================================================*/
+
+/*===========================================================================*/
+/* Module local types.                                                       */
+/*===========================================================================*/
+
+/*===========================================================================*/
+/* Module local variables.                                                   */
+/*===========================================================================*/
+
+static uint32_t ts_high;
+static uint32_t ts_last;
+static virtual_timer_t ts_vt;
+static tstamp_t ts_stamps[TS_NUM_SOURCES];
+
+/**
+ * @brief   System time and timestamp of the same system tick edge.
+ */
+static systime_t ts_epoch_sys;
+static tstamp_t ts_epoch;
+
+/*===========================================================================*/
+/* Module local functions.                                                   */
+/*===========================================================================*/
+
+/**
+ * @brief   Extends the counter, must be called within a critical zone.
+ */
+static tstamp_t ts_now(void)
+{
+  rtcnt_t now = port_rt_get_counter_value();
+
+  if (now < ts_last)
+    ts_high++;
+  ts_last = now;
+
+  return ((tstamp_t)ts_high << 32) | now;
+}
+
+static void ts_extend_cb(void *p)
+{
+  (void)p;
+
+  chSysLockFromISR();
+  (void)ts_now();
+  chVTSetI(&ts_vt, TIME_S2I(TS_EXTEND_PERIOD), ts_extend_cb, NULL);
+  chSysUnlockFromISR();
+}
+
+/*===========================================================================*/
+/* Module exported functions.                                                */
+/*===========================================================================*/
+
+/**
+ * @brief   Initializes the timestamp service.
+ * @details Aligns the system time translation on a system tick edge and
+ *          starts the counter extension.
+ *
+ * @api
+ */
+void tsInit(void)
+{
+  systime_t start;
+
+  chSysLock();
+  start = chVTGetSystemTimeX();
+  do
+  {
+    ts_epoch_sys = chVTGetSystemTimeX();
+  } while (ts_epoch_sys == start);
+  ts_epoch = ts_now();
+  chVTSetI(&ts_vt, TIME_S2I(TS_EXTEND_PERIOD), ts_extend_cb, NULL);
+  chSysUnlock();
+}
+
+/**
+ * @brief   Current timestamp.
+ *
+ * @return              The core clock cycles since boot.
+ *
+ * @xclass
+ */
+tstamp_t tsNowX(void)
+{
+  syssts_t sts;
+  tstamp_t ts;
+
+  sts = chSysGetStatusAndLockX();
+  ts = ts_now();
+  chSysRestoreStatusX(sts);
+
+  return ts;
+}
+
+/**
+ * @brief   Records the current time for a source.
+ * @note    Meant to be the first statement of the source interrupt
+ *          handler or callback.
+ *
+ * @param[in] source    one of the @p TS_SOURCE_* identifiers
+ *
+ * @xclass
+ */
+void tsStampX(unsigned source)
+{
+  syssts_t sts;
+
+  chDbgCheck(source < TS_NUM_SOURCES);
+
+  sts = chSysGetStatusAndLockX();
+  ts_stamps[source] = ts_now();
+  chSysRestoreStatusX(sts);
+}
+
+/**
+ * @brief   Latest stamp of a source.
+ *
+ * @param[in] source    one of the @p TS_SOURCE_* identifiers
+ * @return              The stamp, zero if the source never fired.
+ *
+ * @xclass
+ */
+tstamp_t tsGetStampX(unsigned source)
+{
+  syssts_t sts;
+  tstamp_t ts;
+
+  chDbgCheck(source < TS_NUM_SOURCES);
+
+  sts = chSysGetStatusAndLockX();
+  ts = ts_stamps[source];
+  chSysRestoreStatusX(sts);
+
+  return ts;
+}
+
+/**
+ * @brief   Translates a timestamp to system time.
+ * @note    The core clock and the system timer share the same source, the
+ *          translation does not drift.
+ *
+ * @param[in] ts        timestamp taken after @p tsInit()
+ * @return              The system time at which the stamp was taken.
+ *
+ * @api
+ */
+systime_t tsToSystime(tstamp_t ts)
+{
+  uint64_t ticks = ((ts - ts_epoch) * CH_CFG_ST_FREQUENCY) / TS_FREQUENCY;
+
+  return chTimeAddX(ts_epoch_sys, (sysinterval_t)ticks);
+}
+
+#if (HAL_USE_CAN == TRUE) && (CAN_ENFORCE_USE_CALLBACKS == TRUE)
+/**
+ * @brief   CAN RX callback stamping @p TS_SOURCE_CAN1.
+ * @details The receive interrupt stays masked until the FIFO has been
+ *          drained, the stamp is the arrival time of the first frame of
+ *          each burst. Install it with <tt>CAND1.rxfull_cb = tsCANRxFullCb</tt>.
+ *
+ * @param[in] canp      pointer to the @p CANDriver object
+ * @param[in] flags     RX FIFO flags
+ *
+ * @notapi
+ */
+void tsCANRxFullCb(CANDriver *canp, uint32_t flags)
+{
+  (void)canp;
+  (void)flags;
+
+  tsStampX(TS_SOURCE_CAN1);
+}
+#endif
+
+/** @} */
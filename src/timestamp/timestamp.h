@@ -0,0 +1,124 @@
+/**
+ * @file    timestamp.h
+ * @brief   High resolution timestamp service.
+ *
+ * @addtogroup TIMESTAMP
+ * @{
+ */
+
+#ifndef TIMESTAMP_H
+#define TIMESTAMP_H
+
+#include "ch.h"
+#include "hal.h"
+
+/*===========================================================================*/
+/* Module constants.                                                         */
+/*===========================================================================*/
+
+/**
+ * @brief   Timestamp counter frequency, the core clock.
+ */
+#define TS_FREQUENCY STM32_HCLK
+
+/**
+ * @brief   Timestamp interval to seconds in Q31, shifted by 24 bits.
+ */
+#define TS_DT_K ((uint32_t)((1ULL << 55) / TS_FREQUENCY))
+
+/**
+ * @name    Stamped sources
+ * @{
+ */
+#define TS_SOURCE_CAN1 0 /**< @brief CAN1 RX FIFO interrupt.         */
+#define TS_SOURCE_UART 1 /**< @brief UART frame interrupt.           */
+#define TS_SOURCE_IMU 2  /**< @brief IMU data ready interrupt.       */
+#define TS_SOURCE_ADC 3  /**< @brief ADC block interrupt.            */
+#define TS_NUM_SOURCES 4
+/** @} */
+
+/*===========================================================================*/
+/* Module pre-compile time settings.                                         */
+/*===========================================================================*/
+
+/**
+ * @brief   Period of the counter extension timer, in seconds.
+ * @note    The 32 bits cycle counter must be observed at least once per
+ *          wrap, about 59 s at 72 MHz.
+ */
+#if !defined(TS_EXTEND_PERIOD) || defined(__DOXYGEN__)
+#define TS_EXTEND_PERIOD 10
+#endif
+
+/*===========================================================================*/
+/* Derived constants and error checks.                                       */
+/*===========================================================================*/
+
+#if (TS_EXTEND_PERIOD * TS_FREQUENCY) >= 0x100000000
+#error "TS_EXTEND_PERIOD longer than a cycle counter wrap"
+#endif
+
+/*===========================================================================*/
+/* Module data structures and types.                                         */
+/*===========================================================================*/
+
+/**
+ * @brief   Timestamp, core clock cycles since boot.
+ */
+typedef uint64_t tstamp_t;
+
+/*===========================================================================*/
+/* Module macros.                                                            */
+/*===========================================================================*/
+
+/**
+ * @brief   Timestamp interval to microseconds.
+ *
+ * @param[in] ts        interval in core clock cycles
+ * @return              The interval in microseconds, truncated.
+ */
+#define TS2US(ts) ((uint64_t)(ts) / (TS_FREQUENCY / 1000000U))
+
+/**
+ * @brief   Microseconds to timestamp interval.
+ *
+ * @param[in] us        interval in microseconds
+ * @return              The interval in core clock cycles.
+ */
+#define US2TS(us) ((tstamp_t)(us) * (TS_FREQUENCY / 1000000U))
+
+/**
+ * @brief   Timestamp interval to seconds in Q31.
+ *
+ * @param[in] ts        interval in core clock cycles, under one second
+ * @return              The interval in seconds, Q31.
+ */
+#define TS2Q31(ts) ((int32_t)(((uint64_t)(ts) * TS_DT_K) >> 24))
+
+/*===========================================================================*/
+/* External declarations.                                                    */
+/*===========================================================================*/
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+  void tsInit(void);
+  tstamp_t tsNowX(void);
+  void tsStampX(unsigned source);
+  tstamp_t tsGetStampX(unsigned source);
+  systime_t tsToSystime(tstamp_t ts);
+#if (HAL_USE_CAN == TRUE) && (CAN_ENFORCE_USE_CALLBACKS == TRUE)
+  void tsCANRxFullCb(CANDriver *canp, uint32_t flags);
+#endif
+#ifdef __cplusplus
+}
+#endif
+
+/*===========================================================================*/
+/* Module inline functions.                                                  */
+/*===========================================================================*/
+
+#endif /* TIMESTAMP_H */
+
+/** @} */
@@ -0,0 +1,8 @@
+# Timestamp service files.
+TIMESTAMPSRC = $(COREDIR)/src/timestamp/timestamp.c
+
+TIMESTAMPINC = $(COREDIR)/src/timestamp
+
+# Shared variables
+ALLCSRC += $(TIMESTAMPSRC)
+ALLINC  += $(TIMESTAMPINC)
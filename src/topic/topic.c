@@ -0,0 +1,268 @@
+/**
+ * @file    topic.c
+ * @brief   Publish/subscribe topic bus.
+ * @details A publication copies the message once into the next slot of
+ *          the topic ring and broadcasts an event flag, no buffer is
+ *          allocated and no thread is woken unless it waits on the topic.
+ *          Readers never lock: a slot holding message @p k is rewritten
+ *          when the counter reaches @p k + depth, so a read is valid if
+ *          the counter is still below that once the read is done, it is
+ *          retried otherwise. Latest-value readers use the newest slot,
+ *          in place or copied out, queued subscribers walk the ring at
+ *          their own pace and skip what was overwritten, counting it as
+ *          dropped. There must be a single publisher per topic.
+ *
+ * @addtogroup TOPIC
+ * @{
+ */
+
+#include <string.h>
+
+#include "ch.h"
+#include "hal.h"
+#include "topic.h"
+
+/*===========================================================================*/
+/* Module local definitions.                                                 */
+/*===========================================================================*/
+
+/*===========================================================================*/
+/* Module exported variables.                                                */
+/*===========================================================================*/
+
+/*===========================================================================*/
+/* Module local types.                                                       */
+/*===========================================================================*/
+
+/*===========================================================================*/
+/* Module local variables.                                                   */
+/*===========================================================================*/
+
+/*===========================================================================*/
+/* Module local functions.                                                   */
+/*===========================================================================*/
+
+static inline uint8_t *topic_slot(Topic *tp, uint32_t seq)
+{
+  return &tp->slots[(seq & (tp->depth - 1U)) * tp->size];
+}
+
+static void topic_write(Topic *tp, const void *msg, size_t size)
+{
+  uint32_t seq = tp->seq;
+
+  chDbgCheck((size == tp->size) && (tp->depth >= 2U) &&
+             ((tp->depth & (tp->depth - 1U)) == 0U));
+
+  memcpy(topic_slot(tp, seq), msg, size);
+  __DMB();
+  tp->seq = seq + 1U;
+}
+
+/*===========================================================================*/
+/* Module exported functions.                                                */
+/*===========================================================================*/
+
+/**
+ * @brief   Publishes a message.
+ *
+ * @param[in] tp        pointer to the @p Topic object
+ * @param[in] msg       message
+ * @param[in] size      message size, must be the topic one
+ *
+ * @api
+ */
+void topicPublish(Topic *tp, const void *msg, size_t size)
+{
+  topic_write(tp, msg, size);
+  chEvtBroadcastFlags(&tp->es, TOPIC_FLAG_PUBLISHED);
+}
+
+/**
+ * @brief   Publishes a message from an interrupt.
+ *
+ * @param[in] tp        pointer to the @p Topic object
+ * @param[in] msg       message
+ * @param[in] size      message size, must be the topic one
+ *
+ * @iclass
+ */
+void topicPublishI(Topic *tp, const void *msg, size_t size)
+{
+  chDbgCheckClassI();
+
+  topic_write(tp, msg, size);
+  chEvtBroadcastFlagsI(&tp->es, TOPIC_FLAG_PUBLISHED);
+}
+
+/**
+ * @brief   Latest message, in place.
+ * @details The message must be validated with @p topicCheck() once it
+ *          has been used, it is good for @p depth - 1 more publications.
+ *
+ * @param[in] tp        pointer to the @p Topic object
+ * @param[out] seqp     sequence number of the message
+ * @return              The message, @p NULL if nothing was published.
+ *
+ * @xclass
+ */
+const void *topicPeek(Topic *tp, uint32_t *seqp)
+{
+  uint32_t seq = tp->seq;
+
+  if (seq == 0U)
+    return NULL;
+
+  *seqp = seq - 1U;
+  __DMB();
+  return topic_slot(tp, seq - 1U);
+}
+
+/**
+ * @brief   Checks that a message read in place was not overwritten.
+ *
+ * @param[in] tp        pointer to the @p Topic object
+ * @param[in] seq       sequence number of the message
+ * @return              The message was intact during the read.
+ *
+ * @xclass
+ */
+bool topicCheck(Topic *tp, uint32_t seq)
+{
+  __DMB();
+  return tp->seq - seq < tp->depth;
+}
+
+/**
+ * @brief   Copies the latest message.
+ *
+ * @param[in] tp        pointer to the @p Topic object
+ * @param[out] msg      message
+ * @param[in] size      message size, must be the topic one
+ * @return              The number of messages published up to this one,
+ *                      zero if nothing was published.
+ *
+ * @xclass
+ */
+uint32_t topicGetLatest(Topic *tp, void *msg, size_t size)
+{
+  const void *p;
+  uint32_t seq;
+
+  chDbgCheck(size == tp->size);
+
+  do
+  {
+    p = topicPeek(tp, &seq);
+    if (p == NULL)
+      return 0;
+    memcpy(msg, p, size);
+  } while (!topicCheck(tp, seq));
+
+  return seq + 1U;
+}
+
+/**
+ * @brief   Subscribes to a topic with a queue.
+ * @details Only the messages published from now on are received.
+ *
+ * @param[out] sp       pointer to the @p TopicSub object
+ * @param[in] tp        pointer to the @p Topic object
+ * @param[in] events    events signaled to the calling thread on every
+ *                      publication
+ *
+ * @api
+ */
+void topicSubscribe(TopicSub *sp, Topic *tp, eventmask_t events)
+{
+  sp->topic = tp;
+  sp->next = tp->seq;
+  sp->drops = 0;
+  chEvtRegisterMaskWithFlags(&tp->es, &sp->el, events, TOPIC_FLAG_PUBLISHED);
+}
+
+/**
+ * @brief   Cancels a subscription.
+ *
+ * @param[in] sp        pointer to the @p TopicSub object
+ *
+ * @api
+ */
+void topicUnsubscribe(TopicSub *sp)
+{
+  chEvtUnregister(&sp->topic->es, &sp->el);
+}
+
+/**
+ * @brief   Receives the next queued message.
+ * @details Messages overwritten before being received are dropped.
+ *
+ * @param[in] sp        pointer to the @p TopicSub object
+ * @param[out] msg      message
+ * @param[in] size      message size, must be the topic one
+ * @return              A message was received, the queue was empty
+ *                      otherwise.
+ *
+ * @api
+ */
+bool topicReceive(TopicSub *sp, void *msg, size_t size)
+{
+  Topic *tp = sp->topic;
+  uint32_t seq, lost;
+
+  chDbgCheck(size == tp->size);
+
+  for (;;)
+  {
+    seq = tp->seq;
+    if (sp->next == seq)
+      return false;
+
+    /* The oldest slot is the one being rewritten by the next
+       publication.*/
+    if (seq - sp->next >= tp->depth)
+    {
+      lost = seq - sp->next - (tp->depth - 1U);
+      sp->next += lost;
+      sp->drops += lost;
+      chSysLock();
+      tp->drops += lost;
+      chSysUnlock();
+    }
+
+    __DMB();
+    memcpy(msg, topic_slot(tp, sp->next), size);
+    if (topicCheck(tp, sp->next))
+    {
+      sp->next++;
+      return true;
+    }
+  }
+}
+
+/**
+ * @brief   Reads the topic counters.
+ * @details The rate is averaged since the previous call.
+ *
+ * @param[in] tp        pointer to the @p Topic object
+ * @param[out] stp      statistics
+ *
+ * @api
+ */
+void topicGetStats(Topic *tp, TopicStats *stp)
+{
+  systime_t now = chVTGetSystemTime();
+  uint32_t seq = tp->seq;
+  sysinterval_t dt = chTimeDiffX(tp->stat_time, now);
+
+  stp->published = seq;
+  stp->drops = tp->drops;
+  stp->rate = dt == 0 ? 0
+                      : (uint32_t)(((uint64_t)(seq - tp->stat_seq) *
+                                    CH_CFG_ST_FREQUENCY) /
+                                   dt);
+  tp->stat_seq = seq;
+  tp->stat_time = now;
+}
+
+/** @} */
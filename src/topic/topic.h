@@ -0,0 +1,150 @@
+/**
+ * @file    topic.h
+ * @brief   Publish/subscribe topic bus.
+ *
+ * @addtogroup TOPIC
+ * @{
+ */
+
+#ifndef TOPIC_H
+#define TOPIC_H
+
+#include "ch.h"
+
+/*===========================================================================*/
+/* Module constants.                                                         */
+/*===========================================================================*/
+
+/**
+ * @brief   Event flag broadcast on every publication.
+ */
+#define TOPIC_FLAG_PUBLISHED ((eventflags_t)1)
+
+/*===========================================================================*/
+/* Module pre-compile time settings.                                         */
+/*===========================================================================*/
+
+/*===========================================================================*/
+/* Derived constants and error checks.                                       */
+/*===========================================================================*/
+
+#if CH_CFG_USE_EVENTS == FALSE
+#error "the topic bus requires CH_CFG_USE_EVENTS"
+#endif
+
+/*===========================================================================*/
+/* Module data structures and types.                                         */
+/*===========================================================================*/
+
+/**
+ * @brief   Topic object.
+ * @details Messages are written once into a ring of slots and read in
+ *          place or copied out by the subscribers. A slot is valid as long
+ *          as the publication counter has not moved a full ring past it,
+ *          readers check that after reading instead of taking a lock.
+ */
+typedef struct
+{
+  const char *name;       /**< @brief Topic name.                        */
+  size_t size;            /**< @brief Message size.                      */
+  uint32_t depth;         /**< @brief Number of slots, a power of two.   */
+  uint8_t *slots;         /**< @brief Message ring.                      */
+  volatile uint32_t seq;  /**< @brief Messages published.                */
+  volatile uint32_t drops; /**< @brief Messages lost by the queued
+                                      subscribers.                      */
+  event_source_t es;      /**< @brief Publication event source.          */
+  uint32_t stat_seq;      /**< @brief Counter at the last statistics.    */
+  systime_t stat_time;    /**< @brief Time of the last statistics.       */
+} Topic;
+
+/**
+ * @brief   Queued subscriber object.
+ */
+typedef struct
+{
+  Topic *topic;           /**< @brief Topic.                             */
+  uint32_t next;          /**< @brief Next message to receive.           */
+  uint32_t drops;         /**< @brief Messages lost by this subscriber.  */
+  event_listener_t el;    /**< @brief Publication listener.              */
+} TopicSub;
+
+/**
+ * @brief   Topic statistics.
+ */
+typedef struct
+{
+  uint32_t published;     /**< @brief Messages published.                */
+  uint32_t drops;         /**< @brief Messages lost by the subscribers.  */
+  uint32_t rate;          /**< @brief Publication rate since the previous
+                                      statistics, Hz.                   */
+} TopicStats;
+
+/*===========================================================================*/
+/* Module macros.                                                            */
+/*===========================================================================*/
+
+/**
+ * @brief   Static initializer of a topic.
+ *
+ * @param[in] name      the name of the topic variable
+ * @param[in] type      message type
+ * @param[in] depth     number of slots, a power of two, a queued subscriber
+ *                      can lag by @p depth - 1 messages
+ * @param[in] slots     message ring, an array of @p depth messages
+ */
+#define _TOPIC_DATA(name, type, depth, slots)                             \
+  {#name, sizeof(type), (depth), (uint8_t *)(slots), 0, 0,               \
+   _EVENTSOURCE_DATA(name.es), 0, 0}
+
+/**
+ * @brief   Statically declares a topic and its message ring.
+ *
+ * @param[in] name      the name of the topic variable
+ * @param[in] type      message type
+ * @param[in] depth     number of slots, a power of two
+ */
+#define TOPIC_DECL(name, type, depth)                                     \
+  static type name##_slots[(depth)];                                      \
+  Topic name = _TOPIC_DATA(name, type, depth, name##_slots)
+
+/**
+ * @name    Typed access
+ * @brief   Same as the functions, the message size comes from the type
+ *          of the pointer and is checked against the topic.
+ * @{
+ */
+#define topicPublishT(tp, msgp) topicPublish((tp), (msgp), sizeof(*(msgp)))
+#define topicPublishTI(tp, msgp) topicPublishI((tp), (msgp), sizeof(*(msgp)))
+#define topicGetLatestT(tp, msgp)                                         \
+  topicGetLatest((tp), (msgp), sizeof(*(msgp)))
+#define topicReceiveT(sp, msgp) topicReceive((sp), (msgp), sizeof(*(msgp)))
+/** @} */
+
+/*===========================================================================*/
+/* External declarations.                                                    */
+/*===========================================================================*/
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+  void topicPublish(Topic *tp, const void *msg, size_t size);
+  void topicPublishI(Topic *tp, const void *msg, size_t size);
+  const void *topicPeek(Topic *tp, uint32_t *seqp);
+  bool topicCheck(Topic *tp, uint32_t seq);
+  uint32_t topicGetLatest(Topic *tp, void *msg, size_t size);
+  void topicSubscribe(TopicSub *sp, Topic *tp, eventmask_t events);
+  void topicUnsubscribe(TopicSub *sp);
+  bool topicReceive(TopicSub *sp, void *msg, size_t size);
+  void topicGetStats(Topic *tp, TopicStats *stp);
+#ifdef __cplusplus
+}
+#endif
+
+/*===========================================================================*/
+/* Module inline functions.                                                  */
+/*===========================================================================*/
+
+#endif /* TOPIC_H */
+
+/** @} */
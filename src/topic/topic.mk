@@ -0,0 +1,8 @@
+# Topic bus files.
+TOPICSRC = $(COREDIR)/src/topic/topic.c
+
+TOPICINC = $(COREDIR)/src/topic
+
+# Shared variables
+ALLCSRC += $(TOPICSRC)
+ALLINC  += $(TOPICINC)
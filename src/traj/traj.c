@@ -0,0 +1,295 @@
+/**
+ * @file    traj.c
+ * @brief   Setpoint trajectory generator.
+ * @details Each update picks the fastest velocity that can still stop at
+ *          the target within the acceleration and jerk limits, then the
+ *          fastest acceleration that can still settle on that velocity
+ *          within the jerk limit, and integrates one period. The profile
+ *          is recomputed from the current state every time, so the target
+ *          can move at any point without a discontinuity, and the cost is
+ *          the same on every update. The braking curve is solved for the
+ *          state at the end of the period, so the discrete profile lands
+ *          on the target instead of overshooting by one period. With a
+ *          jerk limit the stopping distance of a full acceleration ramp is
+ *          used, it overestimates the distance of the short moves that
+ *          never reach the acceleration limit.
+ *
+ * @addtogroup TRAJ
+ * @{
+ */
+
+#include "ch.h"
+#include "fixmath.h"
+#include "traj.h"
+
+/*===========================================================================*/
+/* Module local definitions.                                                 */
+/*===========================================================================*/
+
+/**
+ * @brief   Fractional bits of the profile state.
+ */
+#define TRAJ_FRAC 28
+#define TRAJ_ONE (1LL << TRAJ_FRAC)
+
+/*===========================================================================*/
+/* Module exported variables.                                                */
+/*===========================================================================*/
+
+/*===========================================================================*/
+/* Module local types.                                                       */
+/*===========================================================================*/
+
+/*===========================================================================*/
+/* Module local variables.                                                   */
+/*===========================================================================*/
+
+/*===========================================================================*/
+/* Module local functions.                                                   */
+/*===========================================================================*/
+
+/**
+ * @brief   Square root of a product, both factors keep 31 bits.
+ */
+static uint64_t traj_sqrt_mul(uint64_t a, uint64_t b)
+{
+  int sa = 0, sb = 0;
+
+  if (a == 0 || b == 0)
+    return 0;
+
+  if (a >> 31)
+    sa = 33 - __builtin_clzll(a);
+  if (b >> 31)
+    sb = 33 - __builtin_clzll(b);
+  if ((sa + sb) & 1)
+    sa++;
+
+  return (uint64_t)fixSqrt64((a >> sa) * (b >> sb)) << ((sa + sb) / 2);
+}
+
+static uint64_t traj_hypot(uint64_t a, uint64_t b)
+{
+  uint64_t m = a > b ? a : b;
+  int s = 0;
+
+  if (m >> 31)
+    s = 33 - __builtin_clzll(m);
+  a >>= s;
+  b >>= s;
+
+  return (uint64_t)fixSqrt64(a * a + b * b) << s;
+}
+
+static inline int64_t traj_min(int64_t a, int64_t b)
+{
+  return a < b ? a : b;
+}
+
+static inline int64_t traj_abs(int64_t x)
+{
+  return x < 0 ? -x : x;
+}
+
+/*===========================================================================*/
+/* Module exported functions.                                                */
+/*===========================================================================*/
+
+/**
+ * @brief   Initializes a generator at rest.
+ *
+ * @param[out] tp       pointer to the @p Traj object
+ * @param[in] config    pointer to the profile limits
+ * @param[in] p         initial position, also the target
+ *
+ * @api
+ */
+void trajInit(Traj *tp, const TrajConfig *config, int32_t p)
+{
+  uint32_t rate = config->rate;
+
+  chDbgCheck((rate > 0) && (config->vmax > 0) && (config->amax > 0) &&
+             (config->jmax >= 0));
+
+  tp->config = config;
+  tp->vmax = ((int64_t)config->vmax << TRAJ_FRAC) / rate;
+  tp->amax = ((int64_t)config->amax << TRAJ_FRAC) / rate / rate;
+  tp->jmax = ((int64_t)config->jmax << TRAJ_FRAC) / rate / rate / rate;
+  tp->vjerk = 0;
+  if (config->jmax > 0)
+  {
+    /* amax^2 / jmax, in two parts to keep the fractional bits.*/
+    uint64_t a2 = (uint64_t)config->amax * (uint64_t)config->amax;
+    uint64_t q = a2 / (uint64_t)config->jmax;
+    uint64_t r = a2 % (uint64_t)config->jmax;
+
+    if (q >= (1ULL << 34))
+      q = (1ULL << 34) - 1;
+    tp->vjerk = (int64_t)(((q << TRAJ_FRAC) +
+                           (r << TRAJ_FRAC) / (uint64_t)config->jmax) /
+                          rate);
+  }
+  if (tp->amax == 0)
+    tp->amax = 1;
+  chDbgCheck(tp->amax < TRAJ_ONE * 8);
+
+  tp->target = p;
+  tp->velocity = false;
+  trajReset(tp, p, 0);
+}
+
+/**
+ * @brief   Resynchronizes the profile with the actual axis state.
+ * @details The acceleration restarts from zero, the target is kept.
+ *
+ * @param[in] tp        pointer to the @p Traj object
+ * @param[in] p         position, units
+ * @param[in] v         velocity, units/s
+ *
+ * @api
+ */
+void trajReset(Traj *tp, int32_t p, int32_t v)
+{
+  tp->p = (int64_t)p * TRAJ_ONE;
+  tp->v = (int64_t)v * TRAJ_ONE / tp->config->rate;
+  tp->a = 0;
+}
+
+/**
+ * @brief   Moves to a position.
+ * @note    Can be called from any thread.
+ *
+ * @param[in] tp        pointer to the @p Traj object
+ * @param[in] p         target position, units
+ *
+ * @api
+ */
+void trajSetPosition(Traj *tp, int32_t p)
+{
+  chSysLock();
+  tp->target = p;
+  tp->velocity = false;
+  chSysUnlock();
+}
+
+/**
+ * @brief   Moves at a velocity.
+ * @note    Can be called from any thread.
+ *
+ * @param[in] tp        pointer to the @p Traj object
+ * @param[in] v         target velocity, units/s
+ *
+ * @api
+ */
+void trajSetVelocity(Traj *tp, int32_t v)
+{
+  chSysLock();
+  tp->target = v;
+  tp->velocity = true;
+  chSysUnlock();
+}
+
+/**
+ * @brief   Advances the profile by one period.
+ *
+ * @param[in] tp        pointer to the @p Traj object
+ * @param[out] out      setpoint, the velocity and acceleration are meant
+ *                      as feed-forward terms
+ * @return              The target is reached and the profile is at rest.
+ *
+ * @api
+ */
+bool trajUpdate(Traj *tp, TrajPoint *out)
+{
+  const TrajConfig *cfg = tp->config;
+  int64_t vd, dv, ad, vn, m;
+  int32_t target;
+  bool velocity;
+
+  chSysLock();
+  target = tp->target;
+  velocity = tp->velocity;
+  chSysUnlock();
+
+  if (velocity)
+  {
+    vd = (int64_t)target * TRAJ_ONE / cfg->rate;
+    if (vd > tp->vmax)
+      vd = tp->vmax;
+    else if (vd < -tp->vmax)
+      vd = -tp->vmax;
+  }
+  else
+  {
+    int64_t p0 = tp->p, d;
+    uint64_t s, k;
+
+    /* Position once the acceleration is ramped down to zero.*/
+    if (tp->jmax > 0 && tp->a != 0)
+    {
+      uint64_t t0 = ((uint64_t)traj_abs(tp->a) << 16) / (uint64_t)tp->jmax;
+      int64_t vm;
+
+      /* Ramp of t0 periods, Q16, at the mean velocity v + a t0 / 3.*/
+      if (t0 > 0xFFFFFFFFU)
+        t0 = 0xFFFFFFFFU;
+      vm = tp->v + ((tp->a * (int64_t)t0) >> 17) * 2 / 3;
+      p0 += (vm >> 16) * (int64_t)t0 + (((vm & 0xFFFF) * (int64_t)t0) >> 16);
+    }
+    /* Distance left at the end of the period, the velocity is solved
+       for the state after the period to lie on the braking curve.*/
+    d = (int64_t)target * TRAJ_ONE - p0 - tp->v / 2;
+    s = traj_sqrt_mul(8U * (uint64_t)tp->amax, traj_abs(d));
+
+    /* v^2 / 2a + v (a / 2j + 1 / 2) = d, solved for v.*/
+    k = (uint64_t)(tp->vjerk + tp->amax);
+    m = (int64_t)((traj_hypot(k, s) - k) / 2U);
+    m = traj_min(traj_min(m, tp->vmax), traj_abs(d + tp->v / 2));
+    vd = d < 0 ? -m : m;
+  }
+
+  /* Acceleration that lands on the velocity when ramped down.*/
+  dv = vd - tp->v;
+  if (tp->jmax > 0)
+  {
+    dv -= tp->a / 2;
+    m = traj_min(traj_min(tp->amax, traj_abs(dv)),
+                 (int64_t)traj_sqrt_mul(2U * (uint64_t)tp->jmax,
+                                        traj_abs(dv)));
+    ad = dv < 0 ? -m : m;
+    if (ad - tp->a > tp->jmax)
+      ad = tp->a + tp->jmax;
+    else if (ad - tp->a < -tp->jmax)
+      ad = tp->a - tp->jmax;
+  }
+  else
+  {
+    m = traj_min(tp->amax, traj_abs(dv));
+    ad = dv < 0 ? -m : m;
+  }
+
+  vn = tp->v + ad;
+  tp->p += (tp->v + vn) / 2;
+  tp->v = vn;
+  tp->a = ad;
+
+  /* Rounding leftovers within a single step of the limits.*/
+  m = tp->jmax > 0 ? tp->jmax : tp->amax;
+  if (!velocity && traj_abs((int64_t)target * TRAJ_ONE - tp->p) <= m &&
+      traj_abs(tp->v) <= m && traj_abs(tp->a) <= m)
+  {
+    tp->p = (int64_t)target * TRAJ_ONE;
+    tp->v = 0;
+    tp->a = 0;
+  }
+
+  out->p = (int32_t)((tp->p + (1LL << (TRAJ_FRAC - 1))) >> TRAJ_FRAC);
+  out->v = (int32_t)((tp->v * cfg->rate + TRAJ_ONE / 2) >> TRAJ_FRAC);
+  out->a = (int32_t)((tp->a * cfg->rate * cfg->rate + TRAJ_ONE / 2) >>
+                     TRAJ_FRAC);
+
+  return !velocity && tp->v == 0 && tp->a == 0 &&
+         tp->p == (int64_t)target * TRAJ_ONE;
+}
+
+/** @} */
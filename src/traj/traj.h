@@ -0,0 +1,102 @@
+/**
+ * @file    traj.h
+ * @brief   Setpoint trajectory generator.
+ *
+ * @addtogroup TRAJ
+ * @{
+ */
+
+#ifndef TRAJ_H
+#define TRAJ_H
+
+#include "ch.h"
+
+/*===========================================================================*/
+/* Module constants.                                                         */
+/*===========================================================================*/
+
+/*===========================================================================*/
+/* Module pre-compile time settings.                                         */
+/*===========================================================================*/
+
+/*===========================================================================*/
+/* Derived constants and error checks.                                       */
+/*===========================================================================*/
+
+/*===========================================================================*/
+/* Module data structures and types.                                         */
+/*===========================================================================*/
+
+/**
+ * @brief   Profile limits of an axis.
+ * @details Units are chosen by the user, positions must stay within
+ *          +/-2^31 of them and the acceleration limit below 8 units per
+ *          period squared.
+ */
+typedef struct
+{
+  uint32_t rate;  /**< @brief Update rate, Hz.                          */
+  int32_t vmax;   /**< @brief Velocity limit, units/s.                  */
+  int32_t amax;   /**< @brief Acceleration limit, units/s^2.            */
+  int32_t jmax;   /**< @brief Jerk limit, units/s^3, zero for a
+                              trapezoidal profile.                      */
+} TrajConfig;
+
+/**
+ * @brief   Setpoint of one update.
+ */
+typedef struct
+{
+  int32_t p;      /**< @brief Position, units.                          */
+  int32_t v;      /**< @brief Velocity, units/s.                        */
+  int32_t a;      /**< @brief Acceleration, units/s^2.                  */
+} TrajPoint;
+
+/**
+ * @brief   Generator object.
+ * @details The profile state is kept per update period with 28
+ *          fractional bits.
+ */
+typedef struct
+{
+  const TrajConfig *config; /**< @brief Profile limits.                 */
+  int64_t vmax;             /**< @brief Velocity limit per period.      */
+  int64_t amax;             /**< @brief Acceleration limit per period.  */
+  int64_t jmax;             /**< @brief Jerk limit per period.          */
+  int64_t vjerk;            /**< @brief Velocity change of a full
+                                        acceleration ramp.              */
+  int64_t p;                /**< @brief Position.                       */
+  int64_t v;                /**< @brief Velocity.                       */
+  int64_t a;                /**< @brief Acceleration.                   */
+  int32_t target;           /**< @brief Target position or velocity.    */
+  bool velocity;            /**< @brief The target is a velocity.       */
+} Traj;
+
+/*===========================================================================*/
+/* Module macros.                                                            */
+/*===========================================================================*/
+
+/*===========================================================================*/
+/* External declarations.                                                    */
+/*===========================================================================*/
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+  void trajInit(Traj *tp, const TrajConfig *config, int32_t p);
+  void trajReset(Traj *tp, int32_t p, int32_t v);
+  void trajSetPosition(Traj *tp, int32_t p);
+  void trajSetVelocity(Traj *tp, int32_t v);
+  bool trajUpdate(Traj *tp, TrajPoint *out);
+#ifdef __cplusplus
+}
+#endif
+
+/*===========================================================================*/
+/* Module inline functions.                                                  */
+/*===========================================================================*/
+
+#endif /* TRAJ_H */
+
+/** @} */
@@ -0,0 +1,8 @@
+# Trajectory generator files.
+TRAJSRC = $(COREDIR)/src/traj/traj.c
+
+TRAJINC = $(COREDIR)/src/traj
+
+# Shared variables
+ALLCSRC += $(TRAJSRC)
+ALLINC  += $(TRAJINC)
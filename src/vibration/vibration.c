@@ -0,0 +1,332 @@
+/**
+ * @file    vibration.c
+ * @brief   FFT vibration analyser.
+ * @details Samples fed by the sensor path fill a frame buffer, a low
+ *          priority thread applies a Hann window, runs the Q15 real FFT and
+ *          searches the magnitude spectrum for local maxima. The strongest
+ *          ones are matched against the tracked peaks and their frequency
+ *          is refined by parabolic interpolation and low-pass filtered.
+ *          Optionally the strongest tracked peak retunes a notch section.
+ *          Samples fed while a frame is being analysed are dropped.
+ *
+ * @addtogroup VIBRATION
+ * @{
+ */
+
+#include "ch.h"
+#include "hal.h"
+#include "chprintf.h"
+#include "shell.h"
+#include "vibration.h"
+
+/*===========================================================================*/
+/* Module local definitions.                                                 */
+/*===========================================================================*/
+
+#define VIB_BINS (VIB_FFT_SIZE / 2)
+
+/*===========================================================================*/
+/* Module exported variables.                                                */
+/*===========================================================================*/
+
+/*===========================================================================*/
+/* Module local types.                                                       */
+/*===========================================================================*/
+
+/*===========================================================================*/
+/* Module local variables.                                                   */
+/*===========================================================================*/
+
+static const VibConfig *vib_config;
+static arm_rfft_instance_q15 vib_rfft;
+static BSEMAPHORE_DECL(vib_ready, true);
+static THD_WORKING_AREA(vib_wa, VIB_THREAD_WA_SIZE);
+
+/**
+ * @brief   Frame buffer, reused for the magnitude spectrum.
+ */
+static q15_t vib_buf[VIB_FFT_SIZE];
+static q15_t vib_spec[2 * VIB_FFT_SIZE];
+static size_t vib_count;
+
+static VibPeak vib_peaks[VIB_NUM_PEAKS];
+
+/*===========================================================================*/
+/* Module local functions.                                                   */
+/*===========================================================================*/
+
+/**
+ * @brief   Peak frequency from its bin and its neighbours.
+ * @return              The frequency in mHz.
+ */
+static uint32_t vib_bin_freq(const q15_t *m, unsigned k)
+{
+  int32_t a = m[k - 1], b = m[k], c = m[k + 1];
+  int32_t den = a - 2 * b + c;
+  int32_t delta = 0;
+
+  /* Parabola vertex offset in 1/256 of a bin, within half a bin.*/
+  if (den != 0)
+    delta = (128 * (a - c)) / den;
+
+  return (uint32_t)(((uint64_t)((int32_t)(k << 8) + delta) *
+                     vib_config->fs) /
+                    (VIB_FFT_SIZE << 8));
+}
+
+/**
+ * @brief   Matches the new peaks against the tracked ones.
+ */
+static void vib_track(const VibPeak *found, unsigned n)
+{
+  uint32_t width = vib_config->fs / VIB_FFT_SIZE * 2U;
+  bool matched[VIB_NUM_PEAKS] = {false};
+  unsigned i, j, weakest;
+
+  chSysLock();
+  for (i = 0; i < n; i++)
+  {
+    weakest = VIB_NUM_PEAKS;
+    for (j = 0; j < VIB_NUM_PEAKS; j++)
+    {
+      VibPeak *pp = &vib_peaks[j];
+      int32_t d = (int32_t)(found[i].freq - pp->freq);
+
+      if (!matched[j] && pp->freq != 0 && (uint32_t)(d < 0 ? -d : d) < width)
+      {
+        pp->freq += d >> VIB_TRACK_SHIFT;
+        pp->mag = found[i].mag;
+        matched[j] = true;
+        break;
+      }
+      if (!matched[j] &&
+          (weakest == VIB_NUM_PEAKS || pp->mag < vib_peaks[weakest].mag))
+        weakest = j;
+    }
+
+    if (j == VIB_NUM_PEAKS && weakest < VIB_NUM_PEAKS &&
+        found[i].mag > vib_peaks[weakest].mag)
+    {
+      vib_peaks[weakest] = found[i];
+      matched[weakest] = true;
+    }
+  }
+
+  /* Peaks that disappeared fade out.*/
+  for (j = 0; j < VIB_NUM_PEAKS; j++)
+  {
+    if (!matched[j])
+    {
+      /* A quarter of the smallest magnitudes rounds to zero.*/
+      vib_peaks[j].mag = vib_peaks[j].mag > 3
+                             ? vib_peaks[j].mag - (vib_peaks[j].mag >> 2)
+                             : 0;
+      if (vib_peaks[j].mag == 0)
+        vib_peaks[j].freq = 0;
+    }
+  }
+  chSysUnlock();
+}
+
+/**
+ * @brief   Analyses a full frame.
+ */
+static void vib_analyse(void)
+{
+  VibPeak found[VIB_NUM_PEAKS];
+  uint32_t sum = 0;
+  q15_t floor;
+  unsigned i, j, n = 0, kmin;
+
+  /* Hann window, the cosine argument is i / N of a turn.*/
+  for (i = 0; i < VIB_FFT_SIZE; i++)
+  {
+    int32_t w = (32768 - arm_cos_q15((q15_t)((i << 15) / VIB_FFT_SIZE))) / 2;
+
+    if (w > 32767)
+      w = 32767;
+    vib_buf[i] = (q15_t)((vib_buf[i] * w) >> 15);
+  }
+
+  arm_rfft_q15(&vib_rfft, vib_buf, vib_spec);
+  arm_cmplx_mag_q15(vib_spec, vib_buf, VIB_BINS);
+
+  for (i = 0; i < VIB_BINS; i++)
+    sum += (uint16_t)vib_buf[i];
+  sum = sum / VIB_BINS * 4U;
+  floor = (q15_t)(sum > 32767U ? 32767U : sum);
+
+  /* Strongest local maxima well above the average level.*/
+  kmin = (unsigned)(((uint64_t)vib_config->min_freq * VIB_FFT_SIZE) /
+                    vib_config->fs);
+  if (kmin < 2)
+    kmin = 2;
+  for (i = kmin; i < VIB_BINS - 1; i++)
+  {
+    q15_t m = vib_buf[i];
+
+    if (m <= floor || m <= vib_buf[i - 1] || m < vib_buf[i + 1])
+      continue;
+
+    for (j = n; j > 0 && found[j - 1].mag < m; j--)
+    {
+      if (j < VIB_NUM_PEAKS)
+        found[j] = found[j - 1];
+    }
+    if (j < VIB_NUM_PEAKS)
+    {
+      found[j].freq = vib_bin_freq(vib_buf, i);
+      found[j].mag = m;
+      if (n < VIB_NUM_PEAKS)
+        n++;
+    }
+  }
+
+  vib_track(found, n);
+}
+
+static THD_FUNCTION(vib_thread, arg)
+{
+  const VibConfig *cfg = vib_config;
+  VibPeak peaks[VIB_NUM_PEAKS];
+  uint32_t tuned = 0;
+  unsigned i, best;
+
+  (void)arg;
+  chRegSetThreadName("vibration");
+
+  while (true)
+  {
+    chBSemWait(&vib_ready);
+    vib_analyse();
+
+    if (cfg->notch != NULL)
+    {
+      (void)vibGetPeaks(peaks);
+      best = 0;
+      for (i = 1; i < VIB_NUM_PEAKS; i++)
+      {
+        if (peaks[i].mag > peaks[best].mag)
+          best = i;
+      }
+
+      /* Retune only on a move larger than a quarter of a bin.*/
+      if (peaks[best].freq != 0 && peaks[best].mag >= cfg->threshold &&
+          (peaks[best].freq > tuned ? peaks[best].freq - tuned
+                                    : tuned - peaks[best].freq) >
+              cfg->fs / VIB_FFT_SIZE / 4U)
+      {
+        biquadRetune(cfg->notch, cfg->section, peaks[best].freq,
+                     cfg->notch->sections[cfg->section].q);
+        tuned = peaks[best].freq;
+      }
+    }
+
+    chSysLock();
+    vib_count = 0;
+    chSysUnlock();
+  }
+}
+
+/*===========================================================================*/
+/* Module exported functions.                                                */
+/*===========================================================================*/
+
+/**
+ * @brief   Starts the analyser.
+ *
+ * @param[in] config    pointer to the analyser configuration
+ *
+ * @api
+ */
+void vibStart(const VibConfig *config)
+{
+  chDbgCheck((config->notch == NULL) ||
+             (config->section < config->notch->inst.numStages));
+
+  vib_config = config;
+  (void)arm_rfft_init_q15(&vib_rfft, VIB_FFT_SIZE, 0, 1);
+  chThdCreateStatic(vib_wa, sizeof(vib_wa), VIB_THREAD_PRIORITY, vib_thread,
+                    NULL);
+}
+
+/**
+ * @brief   Feeds samples to the analyser.
+ *
+ * @param[in] samples   samples at the configured rate
+ * @param[in] n         number of samples
+ *
+ * @api
+ */
+void vibFeed(const q15_t *samples, size_t n)
+{
+  size_t i;
+
+  chSysLock();
+  for (i = 0; i < n && vib_count < VIB_FFT_SIZE; i++)
+    vib_buf[vib_count++] = samples[i];
+  if (i > 0 && vib_count == VIB_FFT_SIZE)
+    chBSemSignalI(&vib_ready);
+  chSchRescheduleS();
+  chSysUnlock();
+}
+
+/**
+ * @brief   Tracked peaks.
+ *
+ * @param[out] peaks    tracked peaks, unused ones have a zero frequency
+ * @return              The number of used peaks.
+ *
+ * @api
+ */
+unsigned vibGetPeaks(VibPeak peaks[VIB_NUM_PEAKS])
+{
+  unsigned i, n = 0;
+
+  chSysLock();
+  for (i = 0; i < VIB_NUM_PEAKS; i++)
+  {
+    peaks[i] = vib_peaks[i];
+    if (peaks[i].freq != 0)
+      n++;
+  }
+  chSysUnlock();
+
+  return n;
+}
+
+/**
+ * @brief   Shell command listing the tracked peaks.
+ *
+ * @param[in] chp       pointer to the shell stream
+ * @param[in] argc      number of arguments
+ * @param[in] argv      arguments
+ *
+ * @api
+ */
+void vibCmd(BaseSequentialStream *chp, int argc, char *argv[])
+{
+  VibPeak peaks[VIB_NUM_PEAKS];
+  unsigned i;
+
+  (void)argv;
+  if (argc > 0)
+  {
+    shellUsage(chp, "vib");
+    return;
+  }
+
+  (void)vibGetPeaks(peaks);
+  chprintf(chp, "     freq   mag" SHELL_NEWLINE_STR);
+  for (i = 0; i < VIB_NUM_PEAKS; i++)
+  {
+    if (peaks[i].freq != 0)
+      chprintf(chp, "%5lu.%03lu %5d" SHELL_NEWLINE_STR,
+               (unsigned long)(peaks[i].freq / 1000U),
+               (unsigned long)(peaks[i].freq % 1000U), peaks[i].mag);
+  }
+}
+
+SHELL_COMMAND(vib, vibCmd);
+
+/** @} */
@@ -0,0 +1,126 @@
+/**
+ * @file    vibration.h
+ * @brief   FFT vibration analyser.
+ *
+ * @addtogroup VIBRATION
+ * @{
+ */
+
+#ifndef VIBRATION_H
+#define VIBRATION_H
+
+#include "ch.h"
+#include "hal.h"
+#include "arm_math.h"
+#include "biquad.h"
+
+/*===========================================================================*/
+/* Module constants.                                                         */
+/*===========================================================================*/
+
+/*===========================================================================*/
+/* Module pre-compile time settings.                                         */
+/*===========================================================================*/
+
+/**
+ * @brief   Samples per analysis frame, a power of two from 32 to 2048.
+ * @details The RAM footprint is six bytes per sample, the resolution is
+ *          the sampling rate divided by this size.
+ */
+#if !defined(VIB_FFT_SIZE) || defined(__DOXYGEN__)
+#define VIB_FFT_SIZE 256
+#endif
+
+/**
+ * @brief   Number of tracked peaks.
+ */
+#if !defined(VIB_NUM_PEAKS) || defined(__DOXYGEN__)
+#define VIB_NUM_PEAKS 3
+#endif
+
+/**
+ * @brief   Peak frequency tracking filter strength.
+ * @details Each frame moves a tracked peak by 1/2^n of the distance to the
+ *          matching new peak.
+ */
+#if !defined(VIB_TRACK_SHIFT) || defined(__DOXYGEN__)
+#define VIB_TRACK_SHIFT 2
+#endif
+
+/**
+ * @brief   Analysis thread priority.
+ */
+#if !defined(VIB_THREAD_PRIORITY) || defined(__DOXYGEN__)
+#define VIB_THREAD_PRIORITY (LOWPRIO + 1)
+#endif
+
+/**
+ * @brief   Analysis thread working area size.
+ */
+#if !defined(VIB_THREAD_WA_SIZE) || defined(__DOXYGEN__)
+#define VIB_THREAD_WA_SIZE 384
+#endif
+
+/*===========================================================================*/
+/* Derived constants and error checks.                                       */
+/*===========================================================================*/
+
+#if (VIB_FFT_SIZE < 32) || (VIB_FFT_SIZE > 2048) ||                      \
+    ((VIB_FFT_SIZE & (VIB_FFT_SIZE - 1)) != 0)
+#error "VIB_FFT_SIZE must be a power of two from 32 to 2048"
+#endif
+
+/*===========================================================================*/
+/* Module data structures and types.                                         */
+/*===========================================================================*/
+
+/**
+ * @brief   Analyser configuration.
+ */
+typedef struct
+{
+  uint32_t fs;        /**< @brief Sampling rate, in mHz.                 */
+  uint32_t min_freq;  /**< @brief Lowest peak frequency, in mHz.         */
+  Biquad *notch;      /**< @brief Cascade retuned on the strongest peak,
+                                  @p NULL for analysis only.            */
+  unsigned section;   /**< @brief Notch section index in @p notch.       */
+  q15_t threshold;    /**< @brief Smallest peak magnitude that retunes
+                                  the notch, raw FFT magnitude.         */
+} VibConfig;
+
+/**
+ * @brief   Tracked resonance peak.
+ */
+typedef struct
+{
+  uint32_t freq; /**< @brief Frequency in mHz, zero if unused.          */
+  q15_t mag;     /**< @brief Raw FFT magnitude.                         */
+} VibPeak;
+
+/*===========================================================================*/
+/* Module macros.                                                            */
+/*===========================================================================*/
+
+/*===========================================================================*/
+/* External declarations.                                                    */
+/*===========================================================================*/
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+  void vibStart(const VibConfig *config);
+  void vibFeed(const q15_t *samples, size_t n);
+  unsigned vibGetPeaks(VibPeak peaks[VIB_NUM_PEAKS]);
+  void vibCmd(BaseSequentialStream *chp, int argc, char *argv[]);
+#ifdef __cplusplus
+}
+#endif
+
+/*===========================================================================*/
+/* Module inline functions.                                                  */
+/*===========================================================================*/
+
+#endif /* VIBRATION_H */
+
+/** @} */
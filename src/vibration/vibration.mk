@@ -0,0 +1,8 @@
+# Vibration analyser files.
+VIBRATIONSRC = $(COREDIR)/src/vibration/vibration.c
+
+VIBRATIONINC = $(COREDIR)/src/vibration
+
+# Shared variables
+ALLCSRC += $(VIBRATIONSRC)
+ALLINC  += $(VIBRATIONINC)
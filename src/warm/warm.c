@@ -0,0 +1,306 @@
+/**
+ * @file    warm.c
+ * @brief   Warm restart state.
+ * @details The registered variables are copied periodically into a block
+ *          of RAM that the startup code never clears, protected by a CRC
+ *          from the hardware unit. After a watchdog or software reset the
+ *          block is checked and copied back, the estimators resume from
+ *          their last state instead of converging again. A power-on or
+ *          low-power reset, a CRC mismatch or a different firmware image
+ *          start cold. A reset during a save leaves a CRC mismatch, so a
+ *          torn block is never restored.
+ *
+ * @addtogroup WARM
+ * @{
+ */
+
+#include <string.h>
+
+#include "ch.h"
+#include "hal.h"
+#include "chprintf.h"
+#include "shell.h"
+#include "work.h"
+#include "warm.h"
+
+/*===========================================================================*/
+/* Module local definitions.                                                 */
+/*===========================================================================*/
+
+#define WARM_MAGIC 0x5741524DU
+
+/**
+ * @brief   Reset flags that keep the RAM content.
+ */
+#define WARM_RESET_FLAGS                                                  \
+  (RCC_CSR_IWDGRSTF | RCC_CSR_WWDGRSTF | RCC_CSR_SFTRSTF)
+
+/**
+ * @brief   Reset flags that lose it.
+ */
+#define WARM_COLD_FLAGS (RCC_CSR_PORRSTF | RCC_CSR_LPWRRSTF)
+
+/*===========================================================================*/
+/* Module exported variables.                                                */
+/*===========================================================================*/
+
+/*===========================================================================*/
+/* Module local types.                                                       */
+/*===========================================================================*/
+
+/**
+ * @brief   No-init state block.
+ */
+typedef struct
+{
+  uint32_t magic;                 /**< @brief Block written once.        */
+  uint32_t key;                   /**< @brief Image and layout key.      */
+  uint32_t crc;                   /**< @brief CRC of the data.           */
+  uint32_t data[WARM_SIZE / 4];   /**< @brief Registered states.         */
+} WarmBlock;
+
+/*===========================================================================*/
+/* Module local variables.                                                   */
+/*===========================================================================*/
+
+/**
+ * @brief   Registry and image bounds, from the linker script.
+ */
+extern const WarmEntry __warm_base__[], __warm_end__[];
+extern const uint32_t __flash0_start__[], _textdata_start[];
+extern uint32_t _data_start[], _data_end[];
+
+static WarmBlock warm_block __attribute__((section(".noinit")));
+
+static uint32_t warm_flags;
+static uint32_t warm_key;
+static uint32_t warm_used;
+static bool warm_valid;
+static uint32_t warm_saves;
+
+static virtual_timer_t warm_vt;
+static void warm_save_work(void *arg);
+static WORK_DECL(warm_work, warm_save_work, NULL, WORK_PRIO_LOW);
+
+/*===========================================================================*/
+/* Module local functions.                                                   */
+/*===========================================================================*/
+
+/**
+ * @brief   CRC of the used part of the block, hardware unit.
+ */
+static uint32_t warm_crc(void)
+{
+  unsigned i;
+
+  CRC->CR = CRC_CR_RESET;
+  CRC->DR = warm_block.key;
+  for (i = 0; i < warm_used / 4U; i++)
+    CRC->DR = warm_block.data[i];
+
+  return CRC->DR;
+}
+
+/**
+ * @brief   CRC of the loaded flash image, from the vectors to the end of
+ *          the data initializers, hardware unit.
+ * @details A few hundred us on the largest image, run once at start.
+ */
+static uint32_t warm_image_crc(void)
+{
+  const uint32_t *p = __flash0_start__;
+  const uint32_t *end = _textdata_start + (_data_end - _data_start);
+
+  CRC->CR = CRC_CR_RESET;
+  while (p < end)
+    CRC->DR = *p++;
+
+  return CRC->DR;
+}
+
+/**
+ * @brief   Key of the firmware image and of the registered layout.
+ */
+static uint32_t warm_layout_key(void)
+{
+  const WarmEntry *ep;
+  uint32_t h = 2166136261U;
+  const char *p;
+
+  for (ep = __warm_base__; ep < __warm_end__; ep++)
+  {
+    for (p = ep->name; *p != '\0'; p++)
+      h = (h ^ (uint8_t)*p) * 16777619U;
+    h = (h ^ ep->size) * 16777619U;
+  }
+  h = (h ^ warm_image_crc()) * 16777619U;
+
+  return h;
+}
+
+static void warm_save_work(void *arg)
+{
+  (void)arg;
+
+  warmSave();
+}
+
+static void warm_save_cb(void *arg)
+{
+  (void)arg;
+
+  chSysLockFromISR();
+  (void)workPostI(&warm_work);
+  chVTSetI(&warm_vt, TIME_MS2I(WARM_SAVE_PERIOD), warm_save_cb, NULL);
+  chSysUnlockFromISR();
+}
+
+/*===========================================================================*/
+/* Module exported functions.                                                */
+/*===========================================================================*/
+
+/**
+ * @brief   Checks the state block against the reset cause.
+ * @details Called early in @p main(), before any module initialization.
+ *          The reset flags are read and cleared.
+ *
+ * @init
+ */
+void warmInit(void)
+{
+  const WarmEntry *ep;
+
+  warm_flags = RCC->CSR;
+  RCC->CSR |= RCC_CSR_RMVF;
+  RCC->AHBENR |= RCC_AHBENR_CRCEN;
+
+  warm_used = 0;
+  for (ep = __warm_base__; ep < __warm_end__; ep++)
+    warm_used += (ep->size + 3U) & ~3U;
+  chDbgAssert(warm_used <= WARM_SIZE, "WARM_SIZE too small");
+  warm_key = warm_layout_key();
+
+  warm_valid = ((warm_flags & WARM_RESET_FLAGS) != 0U) &&
+               ((warm_flags & WARM_COLD_FLAGS) == 0U) &&
+               (warm_used <= WARM_SIZE) &&
+               (warm_block.magic == WARM_MAGIC) &&
+               (warm_block.key == warm_key) &&
+               (warm_block.crc == warm_crc());
+}
+
+/**
+ * @brief   The saved state is restored on this boot.
+ *
+ * @xclass
+ */
+bool warmIsRestored(void)
+{
+  return warm_valid;
+}
+
+/**
+ * @brief   Reset flags read at boot.
+ *
+ * @return              The @p RCC_CSR reset flags.
+ *
+ * @xclass
+ */
+uint32_t warmGetResetFlags(void)
+{
+  return warm_flags;
+}
+
+/**
+ * @brief   Copies the saved state back into the registered variables.
+ * @details Called after the modules are initialized and before their
+ *          threads start, nothing is copied on a cold boot.
+ *
+ * @init
+ */
+void warmRestore(void)
+{
+  const WarmEntry *ep;
+  const uint8_t *p = (const uint8_t *)warm_block.data;
+
+  if (!warm_valid)
+    return;
+
+  for (ep = __warm_base__; ep < __warm_end__; ep++)
+  {
+    memcpy(ep->data, p, ep->size);
+    p += (ep->size + 3U) & ~3U;
+  }
+}
+
+/**
+ * @brief   Saves the registered variables.
+ * @details Each variable is copied with the kernel locked, it must not be
+ *          left half updated by a preempted writer.
+ *
+ * @api
+ */
+void warmSave(void)
+{
+  const WarmEntry *ep;
+  uint8_t *p = (uint8_t *)warm_block.data;
+
+  if (warm_used > WARM_SIZE)
+    return;
+
+  warm_block.magic = 0;
+  warm_block.key = warm_key;
+  for (ep = __warm_base__; ep < __warm_end__; ep++)
+  {
+    chSysLock();
+    memcpy(p, ep->data, ep->size);
+    chSysUnlock();
+    p += (ep->size + 3U) & ~3U;
+  }
+  warm_block.crc = warm_crc();
+  warm_block.magic = WARM_MAGIC;
+  warm_saves++;
+}
+
+/**
+ * @brief   Starts the periodic saves on the work queue.
+ *
+ * @api
+ */
+void warmStart(void)
+{
+  chVTSet(&warm_vt, TIME_MS2I(WARM_SAVE_PERIOD), warm_save_cb, NULL);
+}
+
+/**
+ * @brief   Shell command showing the reset cause and the state block.
+ *
+ * @param[in] chp       pointer to the shell stream
+ * @param[in] argc      number of arguments
+ * @param[in] argv      arguments
+ *
+ * @api
+ */
+void warmCmd(BaseSequentialStream *chp, int argc, char *argv[])
+{
+  (void)argv;
+  if (argc > 0)
+  {
+    shellUsage(chp, "warm");
+    return;
+  }
+
+  chprintf(chp, "reset:%s%s%s%s%s%s" SHELL_NEWLINE_STR,
+           (warm_flags & RCC_CSR_PORRSTF) ? " power" : "",
+           (warm_flags & RCC_CSR_LPWRRSTF) ? " low-power" : "",
+           (warm_flags & RCC_CSR_IWDGRSTF) ? " iwdg" : "",
+           (warm_flags & RCC_CSR_WWDGRSTF) ? " wwdg" : "",
+           (warm_flags & RCC_CSR_SFTRSTF) ? " software" : "",
+           (warm_flags & RCC_CSR_PINRSTF) ? " pin" : "");
+  chprintf(chp, "state: %s, %lu/%u bytes, %lu saves" SHELL_NEWLINE_STR,
+           warm_valid ? "restored" : "cold", (unsigned long)warm_used,
+           (unsigned)WARM_SIZE, (unsigned long)warm_saves);
+}
+
+SHELL_COMMAND(warm, warmCmd);
+
+/** @} */
@@ -0,0 +1,104 @@
+/**
+ * @file    warm.h
+ * @brief   Warm restart state.
+ *
+ * @addtogroup WARM
+ * @{
+ */
+
+#ifndef WARM_H
+#define WARM_H
+
+#include "ch.h"
+#include "hal.h"
+
+/*===========================================================================*/
+/* Module constants.                                                         */
+/*===========================================================================*/
+
+/*===========================================================================*/
+/* Module pre-compile time settings.                                         */
+/*===========================================================================*/
+
+/**
+ * @brief   Capacity of the state block, in bytes.
+ */
+#if !defined(WARM_SIZE) || defined(__DOXYGEN__)
+#define WARM_SIZE 512
+#endif
+
+/**
+ * @brief   Period of the state saves started by @p warmStart(), in ms.
+ */
+#if !defined(WARM_SAVE_PERIOD) || defined(__DOXYGEN__)
+#define WARM_SAVE_PERIOD 100
+#endif
+
+/*===========================================================================*/
+/* Derived constants and error checks.                                       */
+/*===========================================================================*/
+
+#if (WARM_SIZE % 4) != 0
+#error "WARM_SIZE must be a multiple of 4"
+#endif
+
+/*===========================================================================*/
+/* Module data structures and types.                                         */
+/*===========================================================================*/
+
+/**
+ * @brief   Registered state, placed in flash by the linker.
+ */
+typedef struct
+{
+  const char *name;   /**< @brief State name.                           */
+  void *data;         /**< @brief Live state.                           */
+  uint32_t size;      /**< @brief State size.                           */
+} WarmEntry;
+
+/*===========================================================================*/
+/* Module macros.                                                            */
+/*===========================================================================*/
+
+/**
+ * @brief   Registers a statically allocated variable as warm state.
+ * @details The variable is saved into the no-init block and copied back
+ *          after a watchdog or software reset. It must only point to
+ *          objects of the same firmware image, the block is discarded when
+ *          the image or the registered sizes change. Timestamps restart
+ *          from zero on every boot.
+ *
+ * @param[in] name      unique state name, unquoted
+ * @param[in] var       the variable
+ */
+#define WARM_REGISTER(name, var)                                          \
+  static const WarmEntry warm_entry_##name                                \
+      __attribute__((used, section(".warm." #name))) =                    \
+          {#name, (void *)&(var), sizeof(var)}
+
+/*===========================================================================*/
+/* External declarations.                                                    */
+/*===========================================================================*/
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+  void warmInit(void);
+  bool warmIsRestored(void);
+  uint32_t warmGetResetFlags(void);
+  void warmRestore(void);
+  void warmSave(void);
+  void warmStart(void);
+  void warmCmd(BaseSequentialStream *chp, int argc, char *argv[]);
+#ifdef __cplusplus
+}
+#endif
+
+/*===========================================================================*/
+/* Module inline functions.                                                  */
+/*===========================================================================*/
+
+#endif /* WARM_H */
+
+/** @} */
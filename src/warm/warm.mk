@@ -0,0 +1,8 @@
+# Warm restart files.
+WARMSRC = $(COREDIR)/src/warm/warm.c
+
+WARMINC = $(COREDIR)/src/warm
+
+# Shared variables
+ALLCSRC += $(WARMSRC)
+ALLINC  += $(WARMINC)
@@ -0,0 +1,214 @@
+/**
+ * @file    watchdog.c
+ * @brief   Watchdog manager.
+ * @details Every supervised thread checks in within its own deadline, a
+ *          virtual timer checks all of them and kicks the IWDG only when
+ *          none is late. The first late thread is logged into RAM that
+ *          survives the reset and the IWDG is no longer kicked, the reset
+ *          follows within its timeout. The IWDG also covers a stalled
+ *          kernel, where the timer itself stops.
+ *
+ * @addtogroup WATCHDOG
+ * @{
+ */
+
+#include <string.h>
+
+#include "ch.h"
+#include "hal.h"
+#include "chprintf.h"
+#include "shell.h"
+#include "warm.h"
+#include "watchdog.h"
+
+/*===========================================================================*/
+/* Module local definitions.                                                 */
+/*===========================================================================*/
+
+#define WATCHDOG_MAGIC 0x57444F47U
+
+/*===========================================================================*/
+/* Module exported variables.                                                */
+/*===========================================================================*/
+
+/*===========================================================================*/
+/* Module local types.                                                       */
+/*===========================================================================*/
+
+/**
+ * @brief   Reset log in no-init RAM.
+ */
+typedef struct
+{
+  uint32_t magic;     /**< @brief Log written once.                     */
+  WatchdogLog log;    /**< @brief Late thread.                          */
+  uint32_t check;     /**< @brief Inverted copy of the reset count.     */
+} WatchdogRecord;
+
+/*===========================================================================*/
+/* Module local variables.                                                   */
+/*===========================================================================*/
+
+/**
+ * @brief   IWDG configuration, LSI divided by 32.
+ */
+static const WDGConfig wdg_config = {STM32_IWDG_PR_32,
+                                     WATCHDOG_TIMEOUT * 5 / 4};
+
+static WatchdogRecord wdg_record __attribute__((section(".noinit")));
+
+static WatchdogClient *wdg_list;
+static virtual_timer_t wdg_vt;
+static bool wdg_tripped;
+
+/*===========================================================================*/
+/* Module local functions.                                                   */
+/*===========================================================================*/
+
+static bool wdg_record_valid(void)
+{
+  return wdg_record.magic == WATCHDOG_MAGIC &&
+         wdg_record.check == ~wdg_record.log.resets;
+}
+
+static void wdg_log_late(const WatchdogClient *wcp, sysinterval_t late)
+{
+  uint32_t resets = wdg_record_valid() ? wdg_record.log.resets : 0U;
+
+  wdg_record.magic = 0;
+  wdg_record.log.resets = resets + 1U;
+  wdg_record.log.late = (uint32_t)TIME_I2MS(late);
+  strncpy(wdg_record.log.name, wcp->name, WATCHDOG_NAME_SIZE - 1U);
+  wdg_record.log.name[WATCHDOG_NAME_SIZE - 1U] = '\0';
+  wdg_record.check = ~wdg_record.log.resets;
+  wdg_record.magic = WATCHDOG_MAGIC;
+}
+
+static void wdg_check_cb(void *arg)
+{
+  WatchdogClient *wcp;
+  systime_t now;
+
+  (void)arg;
+
+  chSysLockFromISR();
+  now = chVTGetSystemTimeX();
+  for (wcp = wdg_list; wcp != NULL && !wdg_tripped; wcp = wcp->next)
+  {
+    sysinterval_t age = chTimeDiffX(wcp->stamp, now);
+
+    if (age > wcp->deadline)
+    {
+      wdg_log_late(wcp, age);
+      wdg_tripped = true;
+    }
+  }
+  if (!wdg_tripped)
+    wdgResetI(&WDGD1);
+  chVTSetI(&wdg_vt, TIME_MS2I(WATCHDOG_PERIOD), wdg_check_cb, NULL);
+  chSysUnlockFromISR();
+}
+
+/*===========================================================================*/
+/* Module exported functions.                                                */
+/*===========================================================================*/
+
+/**
+ * @brief   Starts the IWDG and the manager.
+ * @note    The IWDG cannot be stopped once started, it is frozen while the
+ *          core is halted by a debugger.
+ *
+ * @api
+ */
+void watchdogStart(void)
+{
+  DBGMCU->CR |= DBGMCU_CR_DBG_IWDG_STOP;
+  wdgStart(&WDGD1, &wdg_config);
+  chVTSet(&wdg_vt, TIME_MS2I(WATCHDOG_PERIOD), wdg_check_cb, NULL);
+}
+
+/**
+ * @brief   Registers a supervised thread.
+ * @details The deadline starts from the registration.
+ *
+ * @param[out] wcp      pointer to the @p WatchdogClient object
+ * @param[in] name      thread name
+ * @param[in] deadline_ms longest interval between two check-ins, ms
+ *
+ * @api
+ */
+void watchdogObjectInit(WatchdogClient *wcp, const char *name,
+                        uint32_t deadline_ms)
+{
+  chDbgCheck(deadline_ms >= WATCHDOG_PERIOD);
+
+  wcp->name = name;
+  wcp->deadline = TIME_MS2I(deadline_ms);
+
+  chSysLock();
+  wcp->stamp = chVTGetSystemTimeX();
+  wcp->next = wdg_list;
+  wdg_list = wcp;
+  chSysUnlock();
+}
+
+/**
+ * @brief   Late thread that caused the last watchdog reset.
+ * @details The log outlives resets of any cause, it is only reported when
+ *          the last reset came from the IWDG.
+ *
+ * @param[out] logp     the logged thread
+ * @return              The last reset was a logged watchdog reset.
+ *
+ * @api
+ */
+bool watchdogGetLog(WatchdogLog *logp)
+{
+  if ((warmGetResetFlags() & RCC_CSR_IWDGRSTF) == 0U || !wdg_record_valid())
+    return false;
+
+  *logp = wdg_record.log;
+  return true;
+}
+
+/**
+ * @brief   Shell command listing the supervised threads.
+ *
+ * @param[in] chp       pointer to the shell stream
+ * @param[in] argc      number of arguments
+ * @param[in] argv      arguments
+ *
+ * @api
+ */
+void watchdogCmd(BaseSequentialStream *chp, int argc, char *argv[])
+{
+  WatchdogClient *wcp;
+  WatchdogLog log;
+
+  if (argc == 1 && !strcmp(argv[0], "clear"))
+  {
+    wdg_record.magic = 0;
+    return;
+  }
+  if (argc > 0)
+  {
+    shellUsage(chp, "watchdog [clear]");
+    return;
+  }
+
+  chprintf(chp, "%-12s %8s %8s" SHELL_NEWLINE_STR, "name", "deadline",
+           "age");
+  for (wcp = wdg_list; wcp != NULL; wcp = wcp->next)
+    chprintf(chp, "%-12s %6lums %6lums" SHELL_NEWLINE_STR, wcp->name,
+             (unsigned long)TIME_I2MS(wcp->deadline),
+             (unsigned long)TIME_I2MS(
+                 chTimeDiffX(wcp->stamp, chVTGetSystemTimeX())));
+
+  if (watchdogGetLog(&log))
+    chprintf(chp, "last reset: %s late by %lums, %lu resets" SHELL_NEWLINE_STR,
+             log.name, (unsigned long)log.late, (unsigned long)log.resets);
+}
+
+SHELL_COMMAND(watchdog, watchdogCmd);
+
+/** @} */
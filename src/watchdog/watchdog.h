@@ -0,0 +1,129 @@
+/**
+ * @file    watchdog.h
+ * @brief   Watchdog manager.
+ *
+ * @addtogroup WATCHDOG
+ * @{
+ */
+
+#ifndef WATCHDOG_H
+#define WATCHDOG_H
+
+#include "ch.h"
+#include "hal.h"
+
+/*===========================================================================*/
+/* Module constants.                                                         */
+/*===========================================================================*/
+
+/*===========================================================================*/
+/* Module pre-compile time settings.                                         */
+/*===========================================================================*/
+
+/**
+ * @brief   Check period of the manager, in ms.
+ */
+#if !defined(WATCHDOG_PERIOD) || defined(__DOXYGEN__)
+#define WATCHDOG_PERIOD 10
+#endif
+
+/**
+ * @brief   IWDG timeout, in ms at the nominal 40 kHz LSI.
+ * @details The LSI runs from 30 to 60 kHz, the actual timeout can be as
+ *          short as two thirds of this.
+ */
+#if !defined(WATCHDOG_TIMEOUT) || defined(__DOXYGEN__)
+#define WATCHDOG_TIMEOUT 50
+#endif
+
+/**
+ * @brief   Longest thread name kept by the reset log.
+ */
+#if !defined(WATCHDOG_NAME_SIZE) || defined(__DOXYGEN__)
+#define WATCHDOG_NAME_SIZE 12
+#endif
+
+/*===========================================================================*/
+/* Derived constants and error checks.                                       */
+/*===========================================================================*/
+
+#if (HAL_USE_WDG == FALSE) || (STM32_WDG_USE_IWDG == FALSE)
+#error "the watchdog manager requires HAL_USE_WDG and STM32_WDG_USE_IWDG"
+#endif
+
+#if (WATCHDOG_PERIOD * 3) > WATCHDOG_TIMEOUT
+#error "WATCHDOG_TIMEOUT must be at least three WATCHDOG_PERIOD"
+#endif
+
+#if (WATCHDOG_TIMEOUT * 5 / 4) > 4095
+#error "WATCHDOG_TIMEOUT longer than the IWDG reload range"
+#endif
+
+/*===========================================================================*/
+/* Module data structures and types.                                         */
+/*===========================================================================*/
+
+/**
+ * @brief   Supervised thread.
+ */
+typedef struct WatchdogClient
+{
+  const char *name;             /**< @brief Thread name.                 */
+  sysinterval_t deadline;       /**< @brief Longest interval between two
+                                            check-ins.                  */
+  volatile systime_t stamp;     /**< @brief Time of the last check-in.   */
+  struct WatchdogClient *next;  /**< @brief Next client.                 */
+} WatchdogClient;
+
+/**
+ * @brief   Late thread logged before a watchdog reset.
+ */
+typedef struct
+{
+  uint32_t resets;                /**< @brief Resets logged.             */
+  uint32_t late;                  /**< @brief Time since the last
+                                              check-in, ms.             */
+  char name[WATCHDOG_NAME_SIZE];  /**< @brief Thread name.               */
+} WatchdogLog;
+
+/*===========================================================================*/
+/* Module macros.                                                            */
+/*===========================================================================*/
+
+/*===========================================================================*/
+/* External declarations.                                                    */
+/*===========================================================================*/
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+  void watchdogStart(void);
+  void watchdogObjectInit(WatchdogClient *wcp, const char *name,
+                          uint32_t deadline_ms);
+  bool watchdogGetLog(WatchdogLog *logp);
+  void watchdogCmd(BaseSequentialStream *chp, int argc, char *argv[]);
+#ifdef __cplusplus
+}
+#endif
+
+/*===========================================================================*/
+/* Module inline functions.                                                  */
+/*===========================================================================*/
+
+/**
+ * @brief   Checks a thread in.
+ * @details A single store, no lock, the owner thread is the only writer.
+ *
+ * @param[in] wcp       pointer to the @p WatchdogClient object
+ *
+ * @xclass
+ */
+static inline void watchdogCheckIn(WatchdogClient *wcp)
+{
+  wcp->stamp = chVTGetSystemTimeX();
+}
+
+#endif /* WATCHDOG_H */
+
+/** @} */
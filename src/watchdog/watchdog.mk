@@ -0,0 +1,8 @@
+# Watchdog manager files.
+WATCHDOGSRC = $(COREDIR)/src/watchdog/watchdog.c
+
+WATCHDOGINC = $(COREDIR)/src/watchdog
+
+# Shared variables
+ALLCSRC += $(WATCHDOGSRC)
+ALLINC  += $(WATCHDOGINC)
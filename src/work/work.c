@@ -0,0 +1,241 @@
+/**
+ * @file    work.c
+ * @brief   Deferred work queue.
+ * @details Interrupt handlers post work items instead of waking a thread
+ *          of their own, a few shared worker threads run them in priority
+ *          order. The items are linked into per-priority lists through
+ *          their own storage, so posting allocates nothing and can never
+ *          overflow, and an item already waiting absorbs further posts.
+ *          The lists are only touched with the kernel locked, which is
+ *          the state an I-class call from an interrupt handler is already
+ *          in, so posting costs a few stores and a thread wakeup.
+ *
+ * @addtogroup WORK
+ * @{
+ */
+
+#include "ch.h"
+#include "work.h"
+
+/*===========================================================================*/
+/* Module local definitions.                                                 */
+/*===========================================================================*/
+
+/*===========================================================================*/
+/* Module exported variables.                                                */
+/*===========================================================================*/
+
+/*===========================================================================*/
+/* Module local types.                                                       */
+/*===========================================================================*/
+
+/**
+ * @brief   Queue of a priority level.
+ */
+typedef struct
+{
+  WorkItem *head;   /**< @brief First item to run.                      */
+  WorkItem *tail;   /**< @brief Last queued item.                       */
+} WorkQueue;
+
+/*===========================================================================*/
+/* Module local variables.                                                   */
+/*===========================================================================*/
+
+static WorkQueue work_queues[WORK_NUM_PRIOS];
+static _THREADS_QUEUE_DECL(work_idle);
+static THD_WORKING_AREA(work_wa[WORK_NUM_THREADS], WORK_THREAD_WA_SIZE);
+
+/*===========================================================================*/
+/* Module local functions.                                                   */
+/*===========================================================================*/
+
+/**
+ * @brief   Dequeues the highest priority item.
+ * @note    Called with the kernel locked.
+ *
+ * @return              The item, @p NULL if none is queued.
+ */
+static WorkItem *work_next(void)
+{
+  unsigned i;
+
+  for (i = 0; i < WORK_NUM_PRIOS; i++)
+  {
+    WorkQueue *qp = &work_queues[i];
+    WorkItem *wp = qp->head;
+
+    if (wp != NULL)
+    {
+      qp->head = wp->next;
+      if (qp->head == NULL)
+        qp->tail = NULL;
+      wp->pending = false;
+      return wp;
+    }
+  }
+
+  return NULL;
+}
+
+static THD_FUNCTION(work_thread, arg)
+{
+  (void)arg;
+  chRegSetThreadName("work");
+
+  chSysLock();
+  while (true)
+  {
+    WorkItem *wp = work_next();
+    WorkFunc func;
+    void *fa;
+
+    if (wp == NULL)
+    {
+      (void)chThdEnqueueTimeoutS(&work_idle, TIME_INFINITE);
+      continue;
+    }
+
+    /* The item can be posted again as soon as the lock is released.*/
+    func = wp->func;
+    fa = wp->arg;
+    chSysUnlock();
+    func(fa);
+    chSysLock();
+  }
+}
+
+/*===========================================================================*/
+/* Module exported functions.                                                */
+/*===========================================================================*/
+
+/**
+ * @brief   Starts the worker threads.
+ * @details Items can be posted before, they run once the workers start.
+ *
+ * @init
+ */
+void workStart(void)
+{
+  unsigned i;
+
+  for (i = 0; i < WORK_NUM_THREADS; i++)
+    chThdCreateStatic(work_wa[i], sizeof(work_wa[i]), WORK_THREAD_PRIORITY,
+                      work_thread, NULL);
+}
+
+/**
+ * @brief   Initializes a work item.
+ *
+ * @param[out] wp       pointer to the @p WorkItem object
+ * @param[in] func      work function
+ * @param[in] arg       work function argument
+ * @param[in] prio      priority, from @p WORK_PRIO_HIGH to
+ *                      @p WORK_PRIO_LOW
+ *
+ * @init
+ */
+void workObjectInit(WorkItem *wp, WorkFunc func, void *arg, unsigned prio)
+{
+  chDbgCheck((func != NULL) && (prio < WORK_NUM_PRIOS));
+
+  wp->func = func;
+  wp->arg = arg;
+  wp->next = NULL;
+  wp->prio = (uint8_t)prio;
+  wp->pending = false;
+  wp->coalesced = 0;
+}
+
+/**
+ * @brief   Posts a work item.
+ * @note    With more than one worker thread an item posted while it runs
+ *          can start again on another worker before the first run ends.
+ *
+ * @param[in] wp        pointer to the @p WorkItem object
+ * @return              The item was queued, it was already pending
+ *                      otherwise.
+ *
+ * @iclass
+ */
+bool workPostI(WorkItem *wp)
+{
+  WorkQueue *qp;
+
+  chDbgCheckClassI();
+  chDbgCheck(wp->prio < WORK_NUM_PRIOS);
+
+  if (wp->pending)
+  {
+    wp->coalesced++;
+    return false;
+  }
+
+  wp->pending = true;
+  wp->next = NULL;
+  qp = &work_queues[wp->prio];
+  if (qp->tail != NULL)
+    qp->tail->next = wp;
+  else
+    qp->head = wp;
+  qp->tail = wp;
+
+  /* A busy worker checks the queues again before sleeping.*/
+  chThdDequeueNextI(&work_idle, MSG_OK);
+  return true;
+}
+
+/**
+ * @brief   Posts a work item.
+ *
+ * @param[in] wp        pointer to the @p WorkItem object
+ * @return              The item was queued, it was already pending
+ *                      otherwise.
+ *
+ * @api
+ */
+bool workPost(WorkItem *wp)
+{
+  bool queued;
+
+  chSysLock();
+  queued = workPostI(wp);
+  chSchRescheduleS();
+  chSysUnlock();
+
+  return queued;
+}
+
+/**
+ * @brief   Removes a pending work item from its queue.
+ * @details An item already running is not stopped.
+ *
+ * @param[in] wp        pointer to the @p WorkItem object
+ * @return              The item was pending.
+ *
+ * @iclass
+ */
+bool workCancelI(WorkItem *wp)
+{
+  WorkQueue *qp = &work_queues[wp->prio];
+  WorkItem *prev = NULL, *p;
+
+  chDbgCheckClassI();
+
+  if (!wp->pending)
+    return false;
+
+  for (p = qp->head; p != wp; p = p->next)
+    prev = p;
+  if (prev != NULL)
+    prev->next = wp->next;
+  else
+    qp->head = wp->next;
+  if (qp->tail == wp)
+    qp->tail = prev;
+  wp->pending = false;
+
+  return true;
+}
+
+/** @} */
@@ -0,0 +1,148 @@
+/**
+ * @file    work.h
+ * @brief   Deferred work queue.
+ *
+ * @addtogroup WORK
+ * @{
+ */
+
+#ifndef WORK_H
+#define WORK_H
+
+#include "ch.h"
+
+/*===========================================================================*/
+/* Module constants.                                                         */
+/*===========================================================================*/
+
+/**
+ * @brief   Highest work priority.
+ */
+#define WORK_PRIO_HIGH 0U
+
+/**
+ * @brief   Lowest work priority.
+ */
+#define WORK_PRIO_LOW (WORK_NUM_PRIOS - 1U)
+
+/*===========================================================================*/
+/* Module pre-compile time settings.                                         */
+/*===========================================================================*/
+
+/**
+ * @brief   Number of work priority levels.
+ */
+#if !defined(WORK_NUM_PRIOS) || defined(__DOXYGEN__)
+#define WORK_NUM_PRIOS 2
+#endif
+
+/**
+ * @brief   Number of worker threads.
+ * @details A second worker lets high priority work run while a long low
+ *          priority item is executing.
+ */
+#if !defined(WORK_NUM_THREADS) || defined(__DOXYGEN__)
+#define WORK_NUM_THREADS 1
+#endif
+
+/**
+ * @brief   Worker threads priority.
+ */
+#if !defined(WORK_THREAD_PRIORITY) || defined(__DOXYGEN__)
+#define WORK_THREAD_PRIORITY (NORMALPRIO + 1)
+#endif
+
+/**
+ * @brief   Worker thread working area size.
+ */
+#if !defined(WORK_THREAD_WA_SIZE) || defined(__DOXYGEN__)
+#define WORK_THREAD_WA_SIZE 256
+#endif
+
+/*===========================================================================*/
+/* Derived constants and error checks.                                       */
+/*===========================================================================*/
+
+#if (WORK_NUM_PRIOS < 1) || (WORK_NUM_PRIOS > 8)
+#error "WORK_NUM_PRIOS must be from 1 to 8"
+#endif
+
+#if WORK_NUM_THREADS < 1
+#error "WORK_NUM_THREADS must be at least 1"
+#endif
+
+/*===========================================================================*/
+/* Module data structures and types.                                         */
+/*===========================================================================*/
+
+/**
+ * @brief   Work function.
+ */
+typedef void (*WorkFunc)(void *arg);
+
+/**
+ * @brief   Work item.
+ * @details An item is queued at most once, posting a pending item only
+ *          counts the merged post. The pending flag is cleared right
+ *          before the function runs, a post during the execution queues
+ *          the item again so no event is missed.
+ */
+typedef struct WorkItem
+{
+  WorkFunc func;          /**< @brief Work function.                     */
+  void *arg;              /**< @brief Work function argument.            */
+  struct WorkItem *next;  /**< @brief Next queued item.                  */
+  uint8_t prio;           /**< @brief Priority, @p WORK_PRIO_HIGH first. */
+  volatile bool pending;  /**< @brief Queued and not yet started.         */
+  uint32_t coalesced;     /**< @brief Posts merged into a pending one.   */
+} WorkItem;
+
+/*===========================================================================*/
+/* Module macros.                                                            */
+/*===========================================================================*/
+
+/**
+ * @brief   Static initializer of a work item.
+ *
+ * @param[in] func      work function
+ * @param[in] arg       work function argument
+ * @param[in] prio      priority, from @p WORK_PRIO_HIGH to
+ *                      @p WORK_PRIO_LOW
+ */
+#define _WORK_DATA(func, arg, prio) {(func), (arg), NULL, (prio), false, 0}
+
+/**
+ * @brief   Statically declares a work item.
+ *
+ * @param[in] name      the name of the work item variable
+ * @param[in] func      work function
+ * @param[in] arg       work function argument
+ * @param[in] prio      priority
+ */
+#define WORK_DECL(name, func, arg, prio)                                  \
+  WorkItem name = _WORK_DATA(func, arg, prio)
+
+/*===========================================================================*/
+/* External declarations.                                                    */
+/*===========================================================================*/
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+  void workStart(void);
+  void workObjectInit(WorkItem *wp, WorkFunc func, void *arg, unsigned prio);
+  bool workPostI(WorkItem *wp);
+  bool workPost(WorkItem *wp);
+  bool workCancelI(WorkItem *wp);
+#ifdef __cplusplus
+}
+#endif
+
+/*===========================================================================*/
+/* Module inline functions.                                                  */
+/*===========================================================================*/
+
+#endif /* WORK_H */
+
+/** @} */
@@ -0,0 +1,8 @@
+# Deferred work queue files.
+WORKSRC = $(COREDIR)/src/work/work.c
+
+WORKINC = $(COREDIR)/src/work
+
+# Shared variables
+ALLCSRC += $(WORKSRC)
+ALLINC  += $(WORKINC)
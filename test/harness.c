@@ -0,0 +1,260 @@
+/**
+ * @file    harness.c
+ * @brief   Host test harness.
+ * @details Each kernel is checked for accuracy against a reference, as a
+ *          signal to noise ratio in dB, and timed. Host time means little
+ *          on its own, so it is normalised by the time of a plain 32 x 32
+ *          bit multiply-accumulate loop, timed right next to the kernel,
+ *          and reported as MAC equivalent operations per sample. The ratio
+ *          tracks the work done by the kernel well enough across machines
+ *          and clock changes to catch a gross regression, such as a
+ *          kernel falling back to a slower path, the budgets are set with
+ *          a 3x margin over the measured counts to ride out the noise of
+ *          shared machines.
+ *
+ * @addtogroup HARNESS
+ * @{
+ */
+
+#include <math.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include "harness.h"
+
+/*===========================================================================*/
+/* Module local definitions.                                                 */
+/*===========================================================================*/
+
+/**
+ * @brief   Timed runs, the fastest one is kept.
+ */
+#define HARNESS_RUNS 15
+
+/**
+ * @brief   Shortest timed run, nanoseconds.
+ */
+#define HARNESS_MIN_NS 1000000.0
+
+#define HARNESS_MAC_LEN 256
+
+/*===========================================================================*/
+/* Module local variables.                                                   */
+/*===========================================================================*/
+
+static uint32_t harness_seed = 1;
+static unsigned harness_failures;
+static bool harness_bench;
+
+static int32_t harness_mac_a[HARNESS_MAC_LEN];
+static int32_t harness_mac_b[HARNESS_MAC_LEN];
+static volatile int64_t harness_mac_sink;
+
+/*===========================================================================*/
+/* Module local functions.                                                   */
+/*===========================================================================*/
+
+static double harness_now(void)
+{
+  struct timespec ts;
+
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (double)ts.tv_sec * 1e9 + (double)ts.tv_nsec;
+}
+
+/**
+ * @brief   Calibration kernel, one MAC per element.
+ */
+static void harness_mac(void *arg)
+{
+  const int32_t *a = harness_mac_a, *b = harness_mac_b;
+  int64_t acc = 0;
+  unsigned i;
+
+  (void)arg;
+  for (i = 0; i < HARNESS_MAC_LEN; i++)
+  {
+    acc += (int64_t)a[i] * b[i];
+    /* Keeps the compiler from vectorizing the loop, the kernels are
+       scalar code.*/
+    __asm__ volatile("" : "+r"(acc));
+  }
+  harness_mac_sink = acc;
+}
+
+/**
+ * @brief   Number of calls that dwarfs the clock resolution.
+ */
+static unsigned harness_calls(HarnessKernel fn, void *arg)
+{
+  unsigned calls = 1, i;
+
+  for (;;)
+  {
+    double t = harness_now();
+
+    for (i = 0; i < calls; i++)
+      fn(arg);
+    if (harness_now() - t >= HARNESS_MIN_NS)
+      return calls;
+    calls *= 2U;
+  }
+}
+
+/**
+ * @brief   Time of one kernel call, nanoseconds.
+ */
+static double harness_run(HarnessKernel fn, void *arg, unsigned calls)
+{
+  double t = harness_now();
+  unsigned i;
+
+  for (i = 0; i < calls; i++)
+    fn(arg);
+  return (harness_now() - t) / calls;
+}
+
+static void harness_result(const char *name, const char *info, bool ok,
+                           double ops, double ops_max)
+{
+  bool fast = !harness_bench || ops_max <= 0 || ops <= ops_max;
+
+  if (ops_max > 0)
+    printf("%-28s %-26s  ops %7.1f (max %7.1f)  %s\n", name, info, ops,
+           ops_max, ok && fast ? "ok" : (ok ? "SLOW" : "FAIL"));
+  else
+    printf("%-28s %-26s  %-25s  %s\n", name, info, "", ok ? "ok" : "FAIL");
+  if (!ok || !fast)
+    harness_failures++;
+}
+
+/*===========================================================================*/
+/* Module exported functions.                                                */
+/*===========================================================================*/
+
+/**
+ * @brief   Reproducible noise.
+ *
+ * @return              A uniform value in [-1, 1).
+ */
+double harnessRandom(void)
+{
+  harness_seed = harness_seed * 1664525U + 1013904223U;
+  return (double)(int32_t)harness_seed / 2147483648.0;
+}
+
+/**
+ * @brief   Signal to noise ratio of an output against a reference.
+ *
+ * @param[in] ref       reference output
+ * @param[in] out       output under test
+ * @param[in] n         number of samples
+ * @return              The ratio in dB, infinite for an exact match.
+ */
+double harnessSnr(const double *ref, const double *out, size_t n)
+{
+  double sig = 0, err = 0;
+  size_t i;
+
+  for (i = 0; i < n; i++)
+  {
+    sig += ref[i] * ref[i];
+    err += (ref[i] - out[i]) * (ref[i] - out[i]);
+  }
+
+  if (err == 0)
+    return INFINITY;
+  return 10.0 * log10(sig / err);
+}
+
+/**
+ * @brief   Normalised operation count of a kernel.
+ *
+ * @param[in] fn        kernel
+ * @param[in] arg       kernel argument
+ * @param[in] n         samples processed by one call
+ * @return              MAC equivalent operations per sample.
+ */
+double harnessOps(HarnessKernel fn, void *arg, size_t n)
+{
+  unsigned calls = harness_calls(fn, arg);
+  unsigned mac_calls = harness_calls(harness_mac, NULL);
+  double best = INFINITY, mac = INFINITY, t;
+  unsigned run;
+
+  /* Interleaved runs, both see the same clock changes.*/
+  for (run = 0; run < HARNESS_RUNS; run++)
+  {
+    t = harness_run(harness_mac, NULL, mac_calls);
+    if (t < mac)
+      mac = t;
+    t = harness_run(fn, arg, calls);
+    if (t < best)
+      best = t;
+  }
+
+  return best / (mac / HARNESS_MAC_LEN) / (double)n;
+}
+
+/**
+ * @brief   Reports an accuracy and operation count check.
+ *
+ * @param[in] name      kernel name
+ * @param[in] snr       measured signal to noise ratio, dB
+ * @param[in] snr_min   lowest accepted ratio
+ * @param[in] ops       measured operation count
+ * @param[in] ops_max   operation count budget, zero if not timed
+ */
+void harnessReport(const char *name, double snr, double snr_min,
+                   double ops, double ops_max)
+{
+  char info[32];
+
+  snprintf(info, sizeof(info), "snr %7.1f dB (min %5.1f)", snr, snr_min);
+  harness_result(name, info, snr >= snr_min, ops, ops_max);
+}
+
+/**
+ * @brief   Reports a pass or fail check with an operation count.
+ *
+ * @param[in] name      check name
+ * @param[in] ok        the check passed
+ * @param[in] ops       measured operation count
+ * @param[in] ops_max   operation count budget, zero if not timed
+ */
+void harnessCheck(const char *name, bool ok, double ops, double ops_max)
+{
+  harness_result(name, ok ? "pass" : "fail", ok, ops, ops_max);
+}
+
+int main(void)
+{
+  const char *bench = getenv("HARNESS_BENCH");
+  unsigned i;
+
+  /* The budgets can be turned off on a loaded machine.*/
+  harness_bench = bench == NULL || strcmp(bench, "0") != 0;
+
+  for (i = 0; i < HARNESS_MAC_LEN; i++)
+  {
+    harness_mac_a[i] = (int32_t)(i * 2654435761U);
+    harness_mac_b[i] = (int32_t)(i * 40503U);
+  }
+  printf("calibration: %.3f ns per MAC\n\n",
+         harness_run(harness_mac, NULL, harness_calls(harness_mac, NULL)) /
+             HARNESS_MAC_LEN);
+
+  testDsp();
+  testControl();
+  testFilter();
+  testEstimation();
+  testAttitude();
+  testNn();
+
+  printf("\n%u failure(s)\n", harness_failures);
+  return harness_failures == 0 ? 0 : 1;
+}
+
+/** @} */
@@ -0,0 +1,50 @@
+/**
+ * @file    harness.h
+ * @brief   Host test harness.
+ *
+ * @addtogroup HARNESS
+ * @{
+ */
+
+#ifndef HARNESS_H
+#define HARNESS_H
+
+#include <stdbool.h>
+#include <stddef.h>
+
+/*===========================================================================*/
+/* Module data structures and types.                                         */
+/*===========================================================================*/
+
+/**
+ * @brief   Benchmarked kernel, processes one block.
+ */
+typedef void (*HarnessKernel)(void *arg);
+
+/*===========================================================================*/
+/* External declarations.                                                    */
+/*===========================================================================*/
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+  double harnessRandom(void);
+  double harnessSnr(const double *ref, const double *out, size_t n);
+  double harnessOps(HarnessKernel fn, void *arg, size_t n);
+  void harnessReport(const char *name, double snr, double snr_min,
+                     double ops, double ops_max);
+  void harnessCheck(const char *name, bool ok, double ops, double ops_max);
+  void testDsp(void);
+  void testControl(void);
+  void testFilter(void);
+  void testEstimation(void);
+  void testAttitude(void);
+  void testNn(void);
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* HARNESS_H */
+
+/** @} */
@@ -0,0 +1,25 @@
+/**
+ * @file    ch.h
+ * @brief   Host replacement of the kernel header.
+ * @details Only what the tested modules use, locks are no-ops and debug
+ *          checks are assertions.
+ */
+
+#ifndef CH_H
+#define CH_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <assert.h>
+
+#define STM32_HCLK 72000000U
+
+#define chDbgCheck(c) assert(c)
+#define chDbgAssert(c, r) assert(c)
+#define chSysLock()
+#define chSysUnlock()
+#define chSysLockFromISR()
+#define chSysUnlockFromISR()
+
+#endif /* CH_H */
@@ -0,0 +1,49 @@
+/**
+ * @file    core_cm3.h
+ * @brief   Host replacement of the Cortex-M3 core header.
+ * @details C versions of the intrinsics used by CMSIS-DSP and CMSIS-NN on
+ *          a core without the DSP extension.
+ */
+
+#ifndef CORE_CM3_H
+#define CORE_CM3_H
+
+#include <stdint.h>
+
+#define __STATIC_INLINE static inline
+#define __STATIC_FORCEINLINE static inline
+#define __INLINE inline
+#define __ASM __asm
+#define __PACKED __attribute__((packed))
+
+static inline uint32_t __CLZ(uint32_t x)
+{
+  return x != 0U ? (uint32_t)__builtin_clz(x) : 32U;
+}
+
+static inline int32_t __SSAT(int32_t x, uint32_t n)
+{
+  int32_t max = (int32_t)((1U << (n - 1U)) - 1U);
+
+  return x > max ? max : (x < -max - 1 ? -max - 1 : x);
+}
+
+static inline uint32_t __USAT(int32_t x, uint32_t n)
+{
+  int32_t max = (int32_t)((1U << n) - 1U);
+
+  return (uint32_t)(x > max ? max : (x < 0 ? 0 : x));
+}
+
+static inline uint32_t __ROR(uint32_t x, uint32_t n)
+{
+  n %= 32U;
+  return n == 0U ? x : (x >> n) | (x << (32U - n));
+}
+
+static inline void __DMB(void)
+{
+  __sync_synchronize();
+}
+
+#endif /* CORE_CM3_H */
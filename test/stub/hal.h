@@ -0,0 +1,11 @@
+/**
+ * @file    hal.h
+ * @brief   Host replacement of the HAL header.
+ */
+
+#ifndef HAL_H
+#define HAL_H
+
+#include "ch.h"
+
+#endif /* HAL_H */
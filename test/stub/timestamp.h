@@ -0,0 +1,18 @@
+/**
+ * @file    timestamp.h
+ * @brief   Host replacement of the timestamp service header.
+ */
+
+#ifndef TIMESTAMP_H
+#define TIMESTAMP_H
+
+#include "ch.h"
+
+#define TS_FREQUENCY STM32_HCLK
+#define TS_DT_K ((uint32_t)((1ULL << 55) / TS_FREQUENCY))
+#define US2TS(us) ((tstamp_t)(us) * (TS_FREQUENCY / 1000000U))
+#define TS2Q31(ts) ((int32_t)(((uint64_t)(ts) * TS_DT_K) >> 24))
+
+typedef uint64_t tstamp_t;
+
+#endif /* TIMESTAMP_H */
@@ -0,0 +1,223 @@
+/**
+ * @file    test_attitude.c
+ * @brief   Attitude estimator.
+ * @details A timestamped IMU log is synthesised from a tumbling body with
+ *          a biased, noisy and quantised gyro, a noisy accelerometer and a
+ *          jittered 1 kHz sampling clock. The log is replayed through the
+ *          fixed-point estimator and through a double precision Mahony
+ *          filter with the same gains, the drift of the quaternion and of
+ *          the bias estimate between the two is reported along with the
+ *          cost of one sample, which must stay well within the 72000
+ *          cycles of a 1 kHz sample period on the target.
+ */
+
+#include <math.h>
+#include "arm_math.h"
+#include "attitude.h"
+#include "harness.h"
+
+/*===========================================================================*/
+/* Local definitions.                                                        */
+/*===========================================================================*/
+
+#define ATT_SAMPLES 30000
+#define ATT_BLOCK 256
+#define ATT_DT 0.001
+#define ATT_DPS 2000.0
+#define ATT_ACCEL_LSB 4096.0
+#define ATT_KP 1.0
+#define ATT_KI 0.2
+#define ATT_BIAS_MAX 0.2
+
+/*===========================================================================*/
+/* Local variables.                                                          */
+/*===========================================================================*/
+
+static const AttitudeConfig att_config = {
+    .gyro_scale = ATT_GYRO_SCALE(ATT_DPS),
+    .kp = ATT_GAIN(ATT_KP),
+    .ki = ATT_GAIN(ATT_KI),
+    .bias_max = (int32_t)(ATT_BIAS_MAX * 1073741824.0),
+    .accel_min = (uint32_t)(0.5 * ATT_ACCEL_LSB),
+};
+
+static const double att_bias[3] = {0.02, -0.015, 0.01};
+
+static AttitudeSample att_log[ATT_SAMPLES];
+static double att_qref[4 * ATT_SAMPLES], att_qout[4 * ATT_SAMPLES];
+static double att_bref[3 * ATT_SAMPLES], att_bout[3 * ATT_SAMPLES];
+
+static Attitude att_est, att_bench;
+
+/*===========================================================================*/
+/* Local functions.                                                          */
+/*===========================================================================*/
+
+/**
+ * @brief   Quaternion product, body frame rotation of @p q by @p d.
+ */
+static void att_qmul(const double q[4], const double d[4], double out[4])
+{
+  out[0] = q[0] * d[0] - q[1] * d[1] - q[2] * d[2] - q[3] * d[3];
+  out[1] = q[0] * d[1] + q[1] * d[0] + q[2] * d[3] - q[3] * d[2];
+  out[2] = q[0] * d[2] - q[1] * d[3] + q[2] * d[0] + q[3] * d[1];
+  out[3] = q[0] * d[3] + q[1] * d[2] - q[2] * d[1] + q[3] * d[0];
+}
+
+/**
+ * @brief   Rotates a quaternion by a body rate over an interval.
+ */
+static void att_rotate(double q[4], const double w[3], double dt)
+{
+  double h = 0.5 * dt * sqrt(w[0] * w[0] + w[1] * w[1] + w[2] * w[2]);
+  double k = h > 0 ? 0.5 * dt * sin(h) / h : 0.5 * dt;
+  double d[4] = {cos(h), w[0] * k, w[1] * k, w[2] * k}, r[4], n;
+  unsigned i;
+
+  att_qmul(q, d, r);
+  n = sqrt(r[0] * r[0] + r[1] * r[1] + r[2] * r[2] + r[3] * r[3]);
+  for (i = 0; i < 4; i++)
+    q[i] = r[i] / n;
+}
+
+/**
+ * @brief   Gravity direction in the body frame.
+ */
+static void att_gravity(const double q[4], double v[3])
+{
+  v[0] = 2 * (q[1] * q[3] - q[0] * q[2]);
+  v[1] = 2 * (q[0] * q[1] + q[2] * q[3]);
+  v[2] = q[0] * q[0] - q[1] * q[1] - q[2] * q[2] + q[3] * q[3];
+}
+
+static int16_t att_quantize(double x)
+{
+  x = round(x);
+  return (int16_t)(x > 32767 ? 32767 : (x < -32768 ? -32768 : x));
+}
+
+/**
+ * @brief   Double precision Mahony step, the estimator law in floating
+ *          point on the same quantised samples.
+ */
+static void att_reference(double q[4], double b[3], const AttitudeSample *sp,
+                          double dt)
+{
+  double a[3], v[3], e[3] = {0, 0, 0}, w[3], n;
+  unsigned i;
+
+  n = sqrt((double)sp->accel[0] * sp->accel[0] +
+           (double)sp->accel[1] * sp->accel[1] +
+           (double)sp->accel[2] * sp->accel[2]);
+  if (n >= att_config.accel_min && n > 0)
+  {
+    for (i = 0; i < 3; i++)
+      a[i] = sp->accel[i] / n;
+    att_gravity(q, v);
+    e[0] = a[1] * v[2] - a[2] * v[1];
+    e[1] = a[2] * v[0] - a[0] * v[2];
+    e[2] = a[0] * v[1] - a[1] * v[0];
+  }
+
+  for (i = 0; i < 3; i++)
+  {
+    b[i] -= ATT_KI * e[i] * dt;
+    if (b[i] > ATT_BIAS_MAX)
+      b[i] = ATT_BIAS_MAX;
+    else if (b[i] < -ATT_BIAS_MAX)
+      b[i] = -ATT_BIAS_MAX;
+    w[i] = sp->gyro[i] * (ATT_DPS * M_PI / 180.0 / 32768.0) - b[i] +
+           ATT_KP * e[i];
+  }
+  att_rotate(q, w, dt);
+}
+
+static void att_block(void *arg)
+{
+  (void)arg;
+  attUpdate(&att_bench, att_log, ATT_BLOCK);
+}
+
+/*===========================================================================*/
+/* Exported functions.                                                       */
+/*===========================================================================*/
+
+void testAttitude(void)
+{
+  double qt[4] = {1, 0, 0, 0}, qr[4] = {1, 0, 0, 0}, br[3] = {0, 0, 0};
+  double t = 0, g[3], w[3];
+  q31_t q[4], bias[3];
+  unsigned i, j, nq = 0, nb = 0;
+  bool settled = true;
+
+  /* Log of a body tumbling about all three axes.*/
+  for (i = 0; i < ATT_SAMPLES; i++)
+  {
+    AttitudeSample *sp = &att_log[i];
+    double dt = ATT_DT * (1.0 + 0.05 * harnessRandom());
+
+    w[0] = 0.8 * sin(t * 0.7);
+    w[1] = 0.6 * sin(t * 0.45 + 1.0);
+    w[2] = 0.5 * cos(t * 0.3);
+    att_rotate(qt, w, dt);
+    t += dt;
+
+    att_gravity(qt, g);
+    sp->t = (tstamp_t)(t * TS_FREQUENCY);
+    for (j = 0; j < 3; j++)
+    {
+      sp->accel[j] = att_quantize((g[j] + 0.02 * harnessRandom()) *
+                                  ATT_ACCEL_LSB);
+      sp->gyro[j] = att_quantize((w[j] + att_bias[j] +
+                                  0.005 * harnessRandom()) /
+                                 (ATT_DPS * M_PI / 180.0 / 32768.0));
+    }
+  }
+
+  /* Replay, the reference integrates the same clamped intervals.*/
+  attInit(&att_est, &att_config);
+  for (i = 0; i < ATT_SAMPLES; i++)
+  {
+    const AttitudeSample *sp = &att_log[i];
+    double sign;
+
+    attUpdate(&att_est, sp, 1);
+    if (i > 0)
+    {
+      double dt = (double)(sp->t - att_log[i - 1].t) / TS_FREQUENCY;
+
+      att_reference(qr, br, sp, fmin(dt, ATT_MAX_DT_US * 1e-6));
+    }
+
+    attGetQuaternion(&att_est, q);
+    attGetGyroBias(&att_est, bias);
+    sign = q[0] * qr[0] + q[1] * qr[1] + q[2] * qr[2] + q[3] * qr[3] < 0
+               ? -1.0
+               : 1.0;
+    for (j = 0; j < 4; j++)
+    {
+      att_qref[nq] = qr[j];
+      att_qout[nq++] = sign * q[j] / 1073741824.0;
+    }
+
+    /* Second half, once the bias estimate has settled.*/
+    if (i >= ATT_SAMPLES / 2)
+      for (j = 0; j < 3; j++)
+      {
+        att_bref[nb] = br[j];
+        att_bout[nb++] = bias[j] / 1073741824.0;
+      }
+  }
+
+  /* The reference itself tracks the true bias.*/
+  for (j = 0; j < 3; j++)
+    settled = settled && fabs(br[j] - att_bias[j]) < 0.2 * fabs(att_bias[j]);
+
+  attInit(&att_bench, &att_config);
+  harnessReport("attUpdate quaternion drift",
+                harnessSnr(att_qref, att_qout, nq), 80.0,
+                harnessOps(att_block, NULL, ATT_BLOCK), 768.0);
+  harnessReport("attUpdate gyro bias error",
+                harnessSnr(att_bref, att_bout, nb), 55.0, 0.0, 0.0);
+  harnessCheck("attUpdate reference bias", settled, 0.0, 0.0);
+}
@@ -0,0 +1,266 @@
+/**
+ * @file    test_control.c
+ * @brief   Control modules.
+ * @details The PID controller is checked against a double precision model
+ *          of the same law, the state feedback controller against the
+ *          CMSIS matrix product, which also sets its operation budget, and
+ *          the trajectory generator against its profile limits.
+ */
+
+#include <math.h>
+#include <stdlib.h>
+#include "arm_math.h"
+#include "pid.h"
+#include "lqr.h"
+#include "traj.h"
+#include "harness.h"
+
+/*===========================================================================*/
+/* Local definitions.                                                        */
+/*===========================================================================*/
+
+#define CTRL_BLOCK 256
+#define CTRL_STATES 4
+#define CTRL_INPUTS 2
+#define CTRL_RATE 1000
+
+/*===========================================================================*/
+/* Local variables.                                                          */
+/*===========================================================================*/
+
+static const PidQ31Config ctrl_pid_config = {
+    .kp = PID_Q31(0.6),
+    .ki = PID_Q31(0.02),
+    .kd = PID_Q31(0.3),
+    .d_alpha = PID_Q31(0.25),
+    .out_min = PID_Q31(-0.8),
+    .out_max = PID_Q31(0.8),
+};
+
+static const q31_t ctrl_k0[CTRL_INPUTS * CTRL_STATES] = {
+    PID_Q31(0.31), PID_Q31(-0.12), PID_Q31(0.45), PID_Q31(0.07),
+    PID_Q31(-0.22), PID_Q31(0.18), PID_Q31(0.05), PID_Q31(0.39)};
+static const q31_t ctrl_k1[CTRL_INPUTS * CTRL_STATES] = {
+    PID_Q31(0.11), PID_Q31(-0.32), PID_Q31(0.25), PID_Q31(0.17),
+    PID_Q31(-0.02), PID_Q31(0.28), PID_Q31(0.15), PID_Q31(0.19)};
+static const LqrGain ctrl_schedule[] = {
+    {PID_Q31(0.0), ctrl_k0},
+    {PID_Q31(0.5), ctrl_k1},
+};
+static const LqrConfig ctrl_lqr_config = {
+    .n = CTRL_STATES,
+    .m = CTRL_INPUTS,
+    .shift = 0,
+    .schedule = ctrl_schedule,
+    .npoints = 2,
+    .umin = INT32_MIN,
+    .umax = INT32_MAX,
+};
+
+static const TrajConfig ctrl_traj_config = {
+    .rate = CTRL_RATE,
+    .vmax = 20000,
+    .amax = 100000,
+    .jmax = 2000000,
+};
+
+static q31_t ctrl_sp[CTRL_BLOCK], ctrl_meas[CTRL_BLOCK];
+static q31_t ctrl_x[CTRL_BLOCK][CTRL_STATES], ctrl_u[CTRL_BLOCK][CTRL_INPUTS];
+static double ctrl_ref[CTRL_BLOCK * CTRL_INPUTS];
+static double ctrl_out[CTRL_BLOCK * CTRL_INPUTS];
+
+static PidQ31 ctrl_pid;
+static Lqr ctrl_lqr;
+static Traj ctrl_traj;
+
+/*===========================================================================*/
+/* Local functions.                                                          */
+/*===========================================================================*/
+
+static double ctrl_clamp(double x, double lo, double hi)
+{
+  return x < lo ? lo : (x > hi ? hi : x);
+}
+
+static void ctrl_pid_block(void *arg)
+{
+  unsigned i;
+
+  (void)arg;
+  for (i = 0; i < CTRL_BLOCK; i++)
+    ctrl_u[i][0] = pidQ31Update(&ctrl_pid, ctrl_sp[i], ctrl_meas[i], 0);
+}
+
+static void ctrl_lqr_block(void *arg)
+{
+  unsigned i;
+
+  (void)arg;
+  for (i = 0; i < CTRL_BLOCK; i++)
+    lqrUpdate(&ctrl_lqr, ctrl_x[i], NULL, ctrl_u[i]);
+}
+
+/**
+ * @brief   Same block through the generic matrix product, the path the
+ *          unrolled kernels replace.
+ */
+static void ctrl_mat_block(void *arg)
+{
+  static q31_t e[CTRL_STATES], u[CTRL_INPUTS];
+  arm_matrix_instance_q31 mk, me, mu;
+  unsigned i, j;
+
+  (void)arg;
+  arm_mat_init_q31(&mk, CTRL_INPUTS, CTRL_STATES, (q31_t *)ctrl_k1);
+  arm_mat_init_q31(&me, CTRL_STATES, 1, e);
+  arm_mat_init_q31(&mu, CTRL_INPUTS, 1, u);
+  for (i = 0; i < CTRL_BLOCK; i++)
+  {
+    for (j = 0; j < CTRL_STATES; j++)
+      e[j] = ctrl_x[i][j];
+    (void)arm_mat_mult_q31(&mk, &me, &mu);
+    for (j = 0; j < CTRL_INPUTS; j++)
+    {
+      q31_t v = clip_q63_to_q31(-(q63_t)u[j]);
+
+      ctrl_u[i][j] = v < ctrl_lqr_config.umin
+                         ? ctrl_lqr_config.umin
+                         : (v > ctrl_lqr_config.umax ? ctrl_lqr_config.umax
+                                                     : v);
+    }
+  }
+}
+
+static void ctrl_traj_block(void *arg)
+{
+  TrajPoint pt;
+  unsigned i;
+
+  (void)arg;
+  trajReset(&ctrl_traj, 0, 0);
+  trajSetPosition(&ctrl_traj, 5000);
+  for (i = 0; i < CTRL_BLOCK; i++)
+    (void)trajUpdate(&ctrl_traj, &pt);
+}
+
+static void test_pid(void)
+{
+  const PidQ31Config *cfg = &ctrl_pid_config;
+  double kp = cfg->kp / 2147483648.0, ki = cfg->ki / 2147483648.0;
+  double kd = cfg->kd / 2147483648.0, alpha = cfg->d_alpha / 2147483648.0;
+  double lo = cfg->out_min / 2147483648.0, hi = cfg->out_max / 2147483648.0;
+  double e1 = 0, pi = 0, d = 0, y = 0;
+  unsigned i;
+
+  /* Setpoint steps on a first order plant, the output saturates.*/
+  for (i = 0; i < CTRL_BLOCK; i++)
+  {
+    ctrl_sp[i] = PID_Q31((i / 64) & 1 ? 0.7 : -0.3);
+    ctrl_meas[i] = (q31_t)((y + 0.01 * harnessRandom()) * 2147483648.0);
+    y += 0.05 * (0.9 * ctrl_meas[i] / 2147483648.0 - y) + 0.02;
+  }
+
+  pidQ31Init(&ctrl_pid, cfg);
+  ctrl_pid_block(NULL);
+  for (i = 0; i < CTRL_BLOCK; i++)
+  {
+    double e = ctrl_clamp((ctrl_sp[i] - (double)ctrl_meas[i]) / 2147483648.0,
+                          -1.0, 1.0);
+
+    d += ((e - e1) * kd - d) * alpha;
+    pi = ctrl_clamp(pi + (kp + ki) * e - kp * e1, lo, hi);
+    e1 = e;
+    ctrl_ref[i] = ctrl_clamp(pi + d, lo, hi);
+    ctrl_out[i] = ctrl_u[i][0] / 2147483648.0;
+  }
+
+  harnessReport("pidQ31Update", harnessSnr(ctrl_ref, ctrl_out, CTRL_BLOCK),
+                140.0, harnessOps(ctrl_pid_block, NULL, CTRL_BLOCK), 32.0);
+}
+
+static void test_lqr(void)
+{
+  static q31_t e[CTRL_STATES], u[CTRL_INPUTS];
+  arm_matrix_instance_q31 mk, me, mu;
+  double ops, mat_ops;
+  unsigned i, j;
+
+  arm_mat_init_q31(&mk, CTRL_INPUTS, CTRL_STATES, (q31_t *)ctrl_k1);
+  arm_mat_init_q31(&me, CTRL_STATES, 1, e);
+  arm_mat_init_q31(&mu, CTRL_INPUTS, 1, u);
+
+  lqrInit(&ctrl_lqr, &ctrl_lqr_config);
+  lqrSchedule(&ctrl_lqr, PID_Q31(0.5));
+  for (i = 0; i < CTRL_BLOCK; i++)
+    for (j = 0; j < CTRL_STATES; j++)
+      ctrl_x[i][j] = (q31_t)(harnessRandom() * 0.4 * 2147483648.0);
+
+  ctrl_lqr_block(NULL);
+  for (i = 0; i < CTRL_BLOCK; i++)
+  {
+    for (j = 0; j < CTRL_STATES; j++)
+      e[j] = ctrl_x[i][j];
+    (void)arm_mat_mult_q31(&mk, &me, &mu);
+    for (j = 0; j < CTRL_INPUTS; j++)
+    {
+      ctrl_ref[i * CTRL_INPUTS + j] = -(double)u[j];
+      ctrl_out[i * CTRL_INPUTS + j] = ctrl_u[i][j];
+    }
+  }
+
+  ops = harnessOps(ctrl_lqr_block, NULL, CTRL_BLOCK);
+  harnessReport("lqrUpdate 4x2",
+                harnessSnr(ctrl_ref, ctrl_out, CTRL_BLOCK * CTRL_INPUTS),
+                INFINITY, ops, 48.0);
+
+  /* The generic path sets the budget of the unrolled one.*/
+  mat_ops = harnessOps(ctrl_mat_block, NULL, CTRL_BLOCK);
+  ctrl_mat_block(NULL);
+  for (i = 0; i < CTRL_BLOCK; i++)
+    for (j = 0; j < CTRL_INPUTS; j++)
+      ctrl_out[i * CTRL_INPUTS + j] = ctrl_u[i][j];
+  harnessReport("mat_mult_q31 path 4x2",
+                harnessSnr(ctrl_ref, ctrl_out, CTRL_BLOCK * CTRL_INPUTS),
+                INFINITY, mat_ops, 96.0);
+  harnessCheck("lqrUpdate vs mat_mult path", true, ops, mat_ops);
+}
+
+static void test_traj(void)
+{
+  const TrajConfig *cfg = &ctrl_traj_config;
+  /* One unit of output rounding on each difference.*/
+  int32_t da_max = cfg->jmax / CTRL_RATE + cfg->amax / CTRL_RATE + 1;
+  TrajPoint pt, last = {0, 0, 0};
+  bool ok = true, done = false;
+  unsigned i;
+
+  trajInit(&ctrl_traj, cfg, 0);
+  trajSetPosition(&ctrl_traj, 5000);
+  for (i = 0; i < 2 * CTRL_RATE && !done; i++)
+  {
+    done = trajUpdate(&ctrl_traj, &pt);
+    ok = ok && pt.p >= last.p && pt.p <= 5000 && abs(pt.v) <= cfg->vmax &&
+         abs(pt.a) <= cfg->amax && abs(pt.a - last.a) <= da_max;
+    last = pt;
+  }
+
+  /* Settled at the target within twice the ideal profile time.*/
+  ok = ok && done && pt.p == 5000 && pt.v == 0 && pt.a == 0 &&
+       i < 2 * (5000 * CTRL_RATE / cfg->vmax + cfg->vmax * CTRL_RATE /
+                                                     cfg->amax +
+                cfg->amax * CTRL_RATE / cfg->jmax);
+
+  harnessCheck("trajUpdate", ok,
+               harnessOps(ctrl_traj_block, NULL, CTRL_BLOCK), 768.0);
+}
+
+/*===========================================================================*/
+/* Exported functions.                                                       */
+/*===========================================================================*/
+
+void testControl(void)
+{
+  test_pid();
+  test_lqr();
+  test_traj();
+}
@@ -0,0 +1,296 @@
+/**
+ * @file    test_dsp.c
+ * @brief   CMSIS-DSP kernels against the reference library.
+ * @details The filtering, controller and matrix kernels must match the
+ *          reference implementations bit for bit. The fast math kernels
+ *          are table based approximations, they are checked against
+ *          double precision.
+ */
+
+#include <math.h>
+#include "arm_math.h"
+#include "ref.h"
+#include "harness.h"
+
+/*===========================================================================*/
+/* Local definitions.                                                        */
+/*===========================================================================*/
+
+#define DSP_BLOCK 256
+#define DSP_SECTIONS 2
+#define DSP_DIM 6
+
+/*===========================================================================*/
+/* Local variables.                                                          */
+/*===========================================================================*/
+
+static q31_t dsp_in[DSP_BLOCK];
+static q31_t dsp_out[2 * DSP_BLOCK];
+static q31_t dsp_ref[2 * DSP_BLOCK];
+static q15_t dsp_in15[DSP_BLOCK];
+static q15_t dsp_out15[DSP_BLOCK];
+static q15_t dsp_ref15[DSP_BLOCK];
+static double dsp_x[2 * DSP_BLOCK];
+static double dsp_y[2 * DSP_BLOCK];
+
+static arm_biquad_casd_df1_inst_q31 dsp_biquad_inst;
+static arm_pid_instance_q31 dsp_pid_q31;
+static arm_pid_instance_q15 dsp_pid_q15;
+static arm_matrix_instance_q31 dsp_mat_a, dsp_mat_b, dsp_mat_c;
+
+/*===========================================================================*/
+/* Local functions.                                                          */
+/*===========================================================================*/
+
+static void dsp_compare(const char *name, const q31_t *ref, const q31_t *out,
+                        size_t n, double snr_min, HarnessKernel fn,
+                        size_t samples, double ops_max)
+{
+  size_t i;
+
+  for (i = 0; i < n; i++)
+  {
+    dsp_x[i] = ref[i];
+    dsp_y[i] = out[i];
+  }
+  harnessReport(name, harnessSnr(dsp_x, dsp_y, n), snr_min,
+                harnessOps(fn, NULL, samples), ops_max);
+}
+
+static void dsp_noise(q31_t *x, size_t n, double scale)
+{
+  size_t i;
+
+  for (i = 0; i < n; i++)
+    x[i] = (q31_t)(harnessRandom() * scale * 2147483648.0);
+}
+
+/*
+ * Kernels timed by the harness.
+ */
+
+static void dsp_biquad(void *arg)
+{
+  (void)arg;
+  arm_biquad_cascade_df1_q31(&dsp_biquad_inst, dsp_in, dsp_out, DSP_BLOCK);
+}
+
+static void dsp_pid_q31_block(void *arg)
+{
+  unsigned i;
+
+  (void)arg;
+  for (i = 0; i < DSP_BLOCK; i++)
+    dsp_out[i] = arm_pid_q31(&dsp_pid_q31, dsp_in[i] >> 4);
+}
+
+static void dsp_pid_q15_block(void *arg)
+{
+  unsigned i;
+
+  (void)arg;
+  for (i = 0; i < DSP_BLOCK; i++)
+    dsp_out15[i] = arm_pid_q15(&dsp_pid_q15, dsp_in15[i]);
+}
+
+static void dsp_mat_mult(void *arg)
+{
+  (void)arg;
+  (void)arm_mat_mult_q31(&dsp_mat_a, &dsp_mat_b, &dsp_mat_c);
+}
+
+static void dsp_mat_trans(void *arg)
+{
+  (void)arg;
+  (void)arm_mat_trans_q31(&dsp_mat_a, &dsp_mat_c);
+}
+
+static void dsp_mat_add(void *arg)
+{
+  (void)arg;
+  (void)arm_mat_add_q31(&dsp_mat_a, &dsp_mat_b, &dsp_mat_c);
+}
+
+static void dsp_sqrt(void *arg)
+{
+  unsigned i;
+
+  (void)arg;
+  for (i = 0; i < DSP_BLOCK; i++)
+    (void)arm_sqrt_q31(dsp_in[i] & INT32_MAX, &dsp_out[i]);
+}
+
+static void dsp_sin_cos(void *arg)
+{
+  unsigned i;
+
+  (void)arg;
+  for (i = 0; i < DSP_BLOCK; i++)
+    arm_sin_cos_q31(dsp_in[i], &dsp_out[2 * i], &dsp_out[2 * i + 1]);
+}
+
+static void dsp_cos(void *arg)
+{
+  unsigned i;
+
+  (void)arg;
+  for (i = 0; i < DSP_BLOCK; i++)
+    dsp_out15[i] = arm_cos_q15(dsp_in15[i] & INT16_MAX);
+}
+
+/*
+ * Checks.
+ */
+
+static void test_biquad(void)
+{
+  static q31_t coeffs[5 * DSP_SECTIONS], state[4 * DSP_SECTIONS];
+  static q31_t ref_state[4 * DSP_SECTIONS];
+  static const double fc[DSP_SECTIONS] = {0.02, 0.08};
+  static const double q[DSP_SECTIONS] = {0.54, 1.31};
+  arm_biquad_casd_df1_inst_q31 ref;
+  unsigned i;
+
+  /* Fourth order Butterworth low-pass, Q30 coefficients.*/
+  for (i = 0; i < DSP_SECTIONS; i++)
+  {
+    double w = 2.0 * M_PI * fc[i], alpha = sin(w) / (2.0 * q[i]);
+    double a0 = 1.0 + alpha, k = 1073741824.0 / a0;
+
+    coeffs[5 * i + 0] = (q31_t)((1.0 - cos(w)) / 2.0 * k);
+    coeffs[5 * i + 1] = (q31_t)((1.0 - cos(w)) * k);
+    coeffs[5 * i + 2] = coeffs[5 * i + 0];
+    coeffs[5 * i + 3] = (q31_t)(2.0 * cos(w) * k);
+    coeffs[5 * i + 4] = (q31_t)(-(1.0 - alpha) * k);
+  }
+
+  for (i = 0; i < DSP_BLOCK; i++)
+    dsp_in[i] = (q31_t)((0.4 * sin(0.05 * i) + 0.2 * sin(1.3 * i) +
+                         0.1 * harnessRandom()) * 2147483648.0);
+
+  arm_biquad_cascade_df1_init_q31(&dsp_biquad_inst, DSP_SECTIONS, coeffs,
+                                  state, 1);
+  arm_biquad_cascade_df1_init_q31(&ref, DSP_SECTIONS, coeffs, ref_state, 1);
+  dsp_biquad(NULL);
+  ref_biquad_cascade_df1_q31(&ref, dsp_in, dsp_ref, DSP_BLOCK);
+  dsp_compare("biquad_cascade_df1_q31 x2", dsp_ref, dsp_out, DSP_BLOCK,
+              INFINITY, dsp_biquad, DSP_BLOCK, 32.0);
+}
+
+static void test_pid(void)
+{
+  arm_pid_instance_q31 ref31;
+  arm_pid_instance_q15 ref15;
+  unsigned i;
+
+  dsp_pid_q31.Kp = 0x40000000;
+  dsp_pid_q31.Ki = 0x01000000;
+  dsp_pid_q31.Kd = 0x0CCCCCCD;
+  arm_pid_init_q31(&dsp_pid_q31, 1);
+  ref31 = dsp_pid_q31;
+
+  dsp_noise(dsp_in, DSP_BLOCK, 0.5);
+  dsp_pid_q31_block(NULL);
+  for (i = 0; i < DSP_BLOCK; i++)
+    dsp_ref[i] = ref_pid_q31(&ref31, dsp_in[i] >> 4);
+  dsp_compare("pid_q31", dsp_ref, dsp_out, DSP_BLOCK, INFINITY,
+              dsp_pid_q31_block, DSP_BLOCK, 10.0);
+
+  dsp_pid_q15.Kp = 0x4000;
+  dsp_pid_q15.Ki = 0x0100;
+  dsp_pid_q15.Kd = 0x0CCD;
+  arm_pid_init_q15(&dsp_pid_q15, 1);
+  ref15 = dsp_pid_q15;
+
+  for (i = 0; i < DSP_BLOCK; i++)
+    dsp_in15[i] = (q15_t)(dsp_in[i] >> 20);
+  dsp_pid_q15_block(NULL);
+  for (i = 0; i < DSP_BLOCK; i++)
+  {
+    dsp_ref[i] = ref_pid_q15(&ref15, dsp_in15[i]);
+    dsp_out[i] = dsp_out15[i];
+  }
+  dsp_compare("pid_q15", dsp_ref, dsp_out, DSP_BLOCK, INFINITY,
+              dsp_pid_q15_block, DSP_BLOCK, 20.0);
+}
+
+static void test_matrix(void)
+{
+  static q31_t a[DSP_DIM * DSP_DIM], b[DSP_DIM * DSP_DIM];
+  static q31_t c[DSP_DIM * DSP_DIM], r[DSP_DIM * DSP_DIM];
+  arm_matrix_instance_q31 ref;
+
+  dsp_noise(a, DSP_DIM * DSP_DIM, 0.4);
+  dsp_noise(b, DSP_DIM * DSP_DIM, 0.4);
+  arm_mat_init_q31(&dsp_mat_a, DSP_DIM, DSP_DIM, a);
+  arm_mat_init_q31(&dsp_mat_b, DSP_DIM, DSP_DIM, b);
+  arm_mat_init_q31(&dsp_mat_c, DSP_DIM, DSP_DIM, c);
+  arm_mat_init_q31(&ref, DSP_DIM, DSP_DIM, r);
+
+  dsp_mat_mult(NULL);
+  (void)ref_mat_mult_q31(&dsp_mat_a, &dsp_mat_b, &ref);
+  dsp_compare("mat_mult_q31 6x6", r, c, DSP_DIM * DSP_DIM, INFINITY,
+              dsp_mat_mult, DSP_DIM * DSP_DIM, 32.0);
+
+  dsp_mat_trans(NULL);
+  (void)ref_mat_trans_q31(&dsp_mat_a, &ref);
+  dsp_compare("mat_trans_q31 6x6", r, c, DSP_DIM * DSP_DIM, INFINITY,
+              dsp_mat_trans, DSP_DIM * DSP_DIM, 4.0);
+
+  dsp_mat_add(NULL);
+  (void)ref_mat_add_q31(&dsp_mat_a, &dsp_mat_b, &ref);
+  dsp_compare("mat_add_q31 6x6", r, c, DSP_DIM * DSP_DIM, INFINITY,
+              dsp_mat_add, DSP_DIM * DSP_DIM, 6.0);
+}
+
+static void test_fast_math(void)
+{
+  unsigned i;
+
+  dsp_noise(dsp_in, DSP_BLOCK, 1.0);
+
+  dsp_sqrt(NULL);
+  for (i = 0; i < DSP_BLOCK; i++)
+  {
+    dsp_x[i] = sqrt((dsp_in[i] & INT32_MAX) / 2147483648.0);
+    dsp_y[i] = dsp_out[i] / 2147483648.0;
+  }
+  harnessReport("sqrt_q31", harnessSnr(dsp_x, dsp_y, DSP_BLOCK), 120.0,
+                harnessOps(dsp_sqrt, NULL, DSP_BLOCK), 64.0);
+
+  dsp_sin_cos(NULL);
+  for (i = 0; i < DSP_BLOCK; i++)
+  {
+    double theta = dsp_in[i] / 2147483648.0 * M_PI;
+
+    dsp_x[2 * i] = sin(theta);
+    dsp_x[2 * i + 1] = cos(theta);
+    dsp_y[2 * i] = dsp_out[2 * i] / 2147483648.0;
+    dsp_y[2 * i + 1] = dsp_out[2 * i + 1] / 2147483648.0;
+  }
+  harnessReport("sin_cos_q31", harnessSnr(dsp_x, dsp_y, 2 * DSP_BLOCK),
+                110.0, harnessOps(dsp_sin_cos, NULL, DSP_BLOCK), 48.0);
+
+  for (i = 0; i < DSP_BLOCK; i++)
+    dsp_in15[i] = (q15_t)(dsp_in[i] >> 16);
+  dsp_cos(NULL);
+  for (i = 0; i < DSP_BLOCK; i++)
+  {
+    dsp_x[i] = cos(2.0 * M_PI * (dsp_in15[i] & INT16_MAX) / 32768.0);
+    dsp_y[i] = dsp_out15[i] / 32768.0;
+  }
+  harnessReport("cos_q15", harnessSnr(dsp_x, dsp_y, DSP_BLOCK), 70.0,
+                harnessOps(dsp_cos, NULL, DSP_BLOCK), 16.0);
+}
+
+/*===========================================================================*/
+/* Exported functions.                                                       */
+/*===========================================================================*/
+
+void testDsp(void)
+{
+  test_biquad();
+  test_pid();
+  test_matrix();
+  test_fast_math();
+}
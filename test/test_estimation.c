@@ -0,0 +1,101 @@
+/**
+ * @file    test_estimation.c
+ * @brief   Estimation modules.
+ * @details The odometry integrates a simulated drive with a biased gyro
+ *          and noisy wheels, the heading and position are checked against
+ *          the exact trajectory once the bias estimate has settled.
+ */
+
+#include <math.h>
+#include "arm_math.h"
+#include "odometry.h"
+#include "harness.h"
+
+/*===========================================================================*/
+/* Local definitions.                                                        */
+/*===========================================================================*/
+
+#define EST_SAMPLES 8192
+#define EST_DT 0.005
+#define EST_BIAS 0.02
+#define EST_SPEED 1000.0
+
+/*===========================================================================*/
+/* Local variables.                                                          */
+/*===========================================================================*/
+
+static const OdomConfig est_config = {
+    .q_pos = ODOM_VAR_POS(5.0),
+    .q_theta = ODOM_VAR_ANGLE(0.002),
+    .q_bias = ODOM_VAR_RATE(0.0005),
+    .p_bias = ODOM_VAR_RATE(0.05),
+    .r_rate = ODOM_VAR_RATE(0.05),
+};
+
+static OdomSample est_samples[EST_SAMPLES];
+static double est_ref[2 * EST_SAMPLES], est_out[2 * EST_SAMPLES];
+static double est_xref[2 * EST_SAMPLES], est_xout[2 * EST_SAMPLES];
+
+static Odometry est_odom;
+
+/*===========================================================================*/
+/* Local functions.                                                          */
+/*===========================================================================*/
+
+static void est_block(void *arg)
+{
+  (void)arg;
+  odomUpdate(&est_odom, est_samples, 256);
+}
+
+/*===========================================================================*/
+/* Exported functions.                                                       */
+/*===========================================================================*/
+
+void testEstimation(void)
+{
+  double x = 0, y = 0, theta = 0;
+  unsigned i, n = 0;
+  OdomPose pose;
+
+  odomInit(&est_odom, &est_config);
+  for (i = 0; i < EST_SAMPLES; i++)
+  {
+    OdomSample *sp = &est_samples[i];
+    double w = 0.5 * sin(i * 0.002);
+
+    sp->t = (tstamp_t)((i + 1) * EST_DT * TS_FREQUENCY);
+    sp->vx = (int32_t)EST_SPEED;
+    sp->vy = 0;
+    sp->gyro = (q31_t)((w + EST_BIAS) * 16777216.0);
+    sp->wheel_rate = (q31_t)((w + 0.05 * harnessRandom()) * 16777216.0);
+
+    odomUpdate(&est_odom, sp, 1);
+    x += EST_SPEED * cos(theta) * EST_DT;
+    y += EST_SPEED * sin(theta) * EST_DT;
+    theta += w * EST_DT;
+
+    /* Second half, once the bias estimate has settled.*/
+    if (i >= EST_SAMPLES / 2)
+    {
+      odomGetPose(&est_odom, &pose);
+      est_ref[2 * n] = cos(theta);
+      est_ref[2 * n + 1] = sin(theta);
+      est_out[2 * n] = cos(pose.theta / 2147483648.0 * M_PI);
+      est_out[2 * n + 1] = sin(pose.theta / 2147483648.0 * M_PI);
+      est_xref[2 * n] = x;
+      est_xref[2 * n + 1] = y;
+      est_xout[2 * n] = pose.x / 32768.0;
+      est_xout[2 * n + 1] = pose.y / 32768.0;
+      n++;
+    }
+  }
+
+  harnessReport("odomUpdate heading", harnessSnr(est_ref, est_out, 2 * n),
+                40.0, harnessOps(est_block, NULL, 256), 1500.0);
+  harnessReport("odomUpdate position", harnessSnr(est_xref, est_xout, 2 * n),
+                40.0, 0.0, 0.0);
+  harnessCheck("odomUpdate gyro bias",
+               fabs(pose.bias / 4294967296.0 - EST_BIAS) < 0.1 * EST_BIAS,
+               0.0, 0.0);
+}
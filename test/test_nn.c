@@ -0,0 +1,135 @@
+/**
+ * @file    test_nn.c
+ * @brief   Inference runtime.
+ * @details A small model covering every layer type is run through the
+ *          runtime and through the CMSIS-NN reference implementations
+ *          layer by layer, the output of every layer must match bit for
+ *          bit.
+ */
+
+#include <string.h>
+#include "arm_math.h"
+#include "arm_nnfunctions.h"
+#include "ref_functions.h"
+#include "nn.h"
+#include "harness.h"
+
+/*===========================================================================*/
+/* Local definitions.                                                        */
+/*===========================================================================*/
+
+#define NNT_INPUTS (10 * 10 * 4)
+#define NNT_OUTPUTS 10
+#define NNT_LAYERS 7
+
+/*===========================================================================*/
+/* Local variables.                                                          */
+/*===========================================================================*/
+
+static q7_t nnt_w1[8 * 3 * 3 * 4], nnt_b1[8];
+static q7_t nnt_w2[3 * 3 * 8], nnt_b2[8];
+static q7_t nnt_w3[NNT_OUTPUTS * 4 * 4 * 8], nnt_b3[NNT_OUTPUTS];
+
+static const NnLayer nnt_layers[] = {
+    {NN_CONV, 10, 10, 4, 8, 3, 3, 1, 1, 1, 1, 0, 7, nnt_w1, nnt_b1},
+    {NN_RELU, 10, 10, 8, 0, 0, 0, 0, 0, 0, 0, 0, 0, NULL, NULL},
+    {NN_DWCONV, 10, 10, 8, 8, 3, 3, 1, 1, 1, 1, 0, 6, nnt_w2, nnt_b2},
+    {NN_MAXPOOL, 10, 10, 8, 0, 2, 2, 0, 0, 2, 2, 0, 0, NULL, NULL},
+    {NN_AVGPOOL, 5, 5, 8, 0, 2, 2, 0, 0, 1, 1, 0, 0, NULL, NULL},
+    {NN_FC, 4, 4, 8, NNT_OUTPUTS, 0, 0, 0, 0, 0, 0, 0, 7, nnt_w3, nnt_b3},
+    {NN_SOFTMAX, 1, 1, NNT_OUTPUTS, 0, 0, 0, 0, 0, 0, 0, 0, 0, NULL, NULL},
+};
+
+static const NnModel nnt_model = {nnt_layers, NNT_LAYERS};
+
+static uint32_t nnt_arena[512];
+static NnNet nnt_net;
+
+/*===========================================================================*/
+/* Local functions.                                                          */
+/*===========================================================================*/
+
+static void nnt_fill(q7_t *p, size_t n, int range)
+{
+  size_t i;
+
+  for (i = 0; i < n; i++)
+    p[i] = (q7_t)(harnessRandom() * range);
+}
+
+static void nnt_run(void *arg)
+{
+  (void)arg;
+  (void)nnRun(&nnt_net);
+}
+
+/*===========================================================================*/
+/* Exported functions.                                                       */
+/*===========================================================================*/
+
+void testNn(void)
+{
+  static const char *const names[NNT_LAYERS] = {
+      "nnRun conv",          "nnRun conv..relu",    "nnRun conv..dwconv",
+      "nnRun conv..maxpool", "nnRun conv..avgpool", "nnRun conv..fc",
+      "nnRun conv..softmax"};
+  static q7_t in[NNT_INPUTS], ref[NNT_LAYERS][800];
+  static q15_t buf[4000];
+  static const size_t sizes[NNT_LAYERS] = {800, 800, 800, 200, 128,
+                                           NNT_OUTPUTS, NNT_OUTPUTS};
+  double r[800], o[800];
+  const q7_t *op;
+  NnModel model;
+  bool fits;
+  unsigned i, k;
+
+  nnt_fill(nnt_w1, sizeof(nnt_w1), 32);
+  nnt_fill(nnt_w2, sizeof(nnt_w2), 32);
+  nnt_fill(nnt_w3, sizeof(nnt_w3), 32);
+  nnt_fill(nnt_b1, sizeof(nnt_b1), 10);
+  nnt_fill(nnt_b2, sizeof(nnt_b2), 10);
+  nnt_fill(nnt_b3, sizeof(nnt_b3), 10);
+  nnt_fill(in, sizeof(in), 128);
+
+  fits = nnArenaSize(&nnt_model) <= sizeof(nnt_arena) &&
+         nnInit(&nnt_net, &nnt_model, nnt_arena, sizeof(nnt_arena));
+  harnessCheck("nnInit arena plan", fits, 0.0, 0.0);
+  if (!fits)
+    return;
+
+  /* Reference output of every layer.*/
+  arm_convolve_HWC_q7_ref_nonsquare(in, 10, 10, 4, nnt_w1, 8, 3, 3, 1, 1, 1,
+                                    1, nnt_b1, 0, 7, ref[0], 10, 10, buf,
+                                    NULL);
+  memcpy(ref[1], ref[0], 800);
+  arm_relu_q7_ref(ref[1], 800);
+  arm_depthwise_separable_conv_HWC_q7_ref_nonsquare(
+      ref[1], 10, 10, 8, nnt_w2, 8, 3, 3, 1, 1, 1, 1, nnt_b2, 0, 6, ref[2],
+      10, 10, buf, NULL);
+  arm_maxpool_q7_HWC_ref(ref[2], 10, 8, 2, 0, 2, 5, NULL, ref[3]);
+  arm_avepool_q7_HWC_ref(ref[3], 5, 8, 2, 0, 1, 4, NULL, ref[4]);
+  arm_fully_connected_q7_ref(ref[4], nnt_w3, 128, NNT_OUTPUTS, 0, 7, nnt_b3,
+                             ref[5], buf);
+  /* No reference softmax, it is the same kernel on both sides.*/
+  arm_softmax_q7(ref[5], NNT_OUTPUTS, ref[6]);
+
+  /* Each prefix of the model ends on the layer under test, a wrong
+     intermediate result cannot hide behind the softmax.*/
+  for (k = 0; k < NNT_LAYERS; k++)
+  {
+    model.layers = nnt_layers;
+    model.nlayers = k + 1U;
+    (void)nnInit(&nnt_net, &model, nnt_arena, sizeof(nnt_arena));
+    memcpy(nnInput(&nnt_net), in, sizeof(in));
+    op = nnRun(&nnt_net);
+
+    for (i = 0; i < sizes[k]; i++)
+    {
+      r[i] = ref[k][i];
+      o[i] = op[i];
+    }
+    harnessReport(names[k], harnessSnr(r, o, sizes[k]), INFINITY,
+                  k == NNT_LAYERS - 1U ? harnessOps(nnt_run, NULL, 1) : 0.0,
+                  k == NNT_LAYERS - 1U ? 300000.0 : 0.0);
+  }
+}